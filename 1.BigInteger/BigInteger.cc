@@ -1,8 +1,11 @@
+#include <algorithm>
 #include <cassert>
-#include <exception>
+#include <stdexcept>
 #include <string>
 
 #include "BigInteger.hh"
+#include "Montgomery.hh"
+#include "ThreadPool.hh"
 
 // constructors
 BigInteger::BigInteger(int num)
@@ -16,6 +19,151 @@ BigInteger::BigInteger(const std::string& str)
 }
 
 
+namespace
+{
+
+// splits the magnitude of `num` into limbs; returns how many are used
+size_t scalarLimbs(long long num, limbs::limb_t (&out)[2])
+{
+    // negate in unsigned arithmetic so that LLONG_MIN is handled
+    unsigned long long mag = num;
+    if (num < 0)
+        mag = -mag;
+    out[0] = static_cast<limbs::limb_t>(mag);
+    out[1] = static_cast<limbs::limb_t>(mag >> limbs::LIMB_BITS);
+    return out[1] ? 2 : (out[0] ? 1 : 0);
+}
+
+int scalarSign(long long num)
+{
+    return (num > 0) - (num < 0);
+}
+
+// scratch space for products computed in place, kept per thread so that
+//   repeated `*=` reuses its capacity
+std::vector<limbs::limb_t>& scratch()
+{
+    static thread_local std::vector<limbs::limb_t> buffer;
+    return buffer;
+}
+
+// the number of bits per digit of a power-of-two radix, or 0
+int radixBits(int base)
+{
+    switch (base) {
+    case 2: return 1;
+    case 8: return 3;
+    case 16: return 4;
+    default: return 0;
+    }
+}
+
+// the value of an alphanumeric digit, or 36 for anything else
+int digitValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if ((c | 0x20) >= 'a' && (c | 0x20) <= 'z')
+        return (c | 0x20) - 'a' + 10;
+    return 36;
+}
+
+// the stream word set by BigInteger::binary
+int binaryFlagIndex()
+{
+    static const int index = std::ios_base::xalloc();
+    return index;
+}
+
+// the radix a stream asks for: its basefield, else 2 after
+//   BigInteger::binary, else 0 when nothing is set
+int streamBase(std::ios_base& ios)
+{
+    switch (ios.flags() & std::ios_base::basefield) {
+    case std::ios_base::hex: return 16;
+    case std::ios_base::oct: return 8;
+    case std::ios_base::dec: return 10;
+    default: return ios.iword(binaryFlagIndex()) ? 2 : 0;
+    }
+}
+
+// multiplies factors[lo, hi) into factors[lo], halving the range; `ends`
+//   holds the running total of the factor lengths, which tells whether a
+//   half is worth forking
+void multiplyRange(std::vector<BigInteger>& factors,
+                   const std::vector<size_t>& ends, size_t lo, size_t hi)
+{
+    if (hi - lo < 2)
+        return;
+    size_t mid = lo + (hi - lo) / 2;
+    size_t len = ends[hi] - ends[lo];
+    TaskGroup group(len >= limbs::parallel_grain ? limbs::shared_pool()
+                                                 : nullptr);
+    group.run([&] { multiplyRange(factors, ends, lo, mid); });
+    multiplyRange(factors, ends, mid, hi);
+    group.wait();
+    factors[lo] *= factors[mid];
+}
+
+#ifdef __SIZEOF_INT128__
+// native 128-bit arithmetic for the fast paths of small values
+__extension__ typedef unsigned __int128 uint128;
+__extension__ typedef __int128 int128;
+
+// requires v.size() <= 4
+uint128 toUint128(const LimbVector& v)
+{
+    uint128 mag = 0;
+    for (size_t i = v.size(); i-- > 0; )
+        mag = (mag << limbs::LIMB_BITS) | v[i];
+    return mag;
+}
+
+void fromUint128(LimbVector& v, uint128 mag)
+{
+    v.clear();
+    while (mag) {
+        v.push_back(static_cast<limbs::limb_t>(mag));
+        mag >>= limbs::LIMB_BITS;
+    }
+}
+
+int128 toInt128(const LimbVector& v, int sign)
+{
+    return sign < 0 ? -static_cast<int128>(toUint128(v))
+                    : static_cast<int128>(toUint128(v));
+}
+
+int int128Sign(int128 x)
+{
+    return (x > 0) - (x < 0);
+}
+
+uint128 int128Magnitude(int128 x)
+{
+    return x < 0 ? -static_cast<uint128>(x) : static_cast<uint128>(x);
+}
+#endif  // __SIZEOF_INT128__
+
+}  // namespace
+
+BigInteger::BigInteger(BigInteger&& other) noexcept
+    : data_(std::move(other.data_)), sign_(other.sign_)
+{
+    other.data_.clear();
+    other.sign_ = 0;
+}
+
+BigInteger& BigInteger::operator=(BigInteger&& other) noexcept
+{
+    data_.swap(other.data_);
+    sign_ = other.sign_;
+    other.data_.clear();
+    other.sign_ = 0;
+    return *this;
+}
+
+
 // unary operators
 BigInteger BigInteger::operator-() const
 {
@@ -28,109 +176,269 @@ BigInteger BigInteger::operator-() const
 // binary operators
 BigInteger BigInteger::operator+(const BigInteger& rhs) const
 {
-    const BigInteger& lhs = *this;
     BigInteger result;
-    if (lhs.sign_ == 0)
-        return rhs;
-    if (rhs.sign_ == 0)
-        return lhs;
-    if (lhs.sign_ == rhs.sign_) {
-        result = lhs.unsignedAdd_(rhs);
-        result.sign_ = lhs.sign_;
-    } else {
-        if (lhs.unsignedLessThan_(rhs)) {
-            result = rhs.unsignedSubtract_(lhs);
-            result.sign_ = rhs.sign_;
-        } else {
-            result = lhs.unsignedSubtract_(rhs);
-            if (result.data_.size() == 1 && result.data_[0] == 0)
-                result.sign_ = 0;
-            else
-                result.sign_ = lhs.sign_;
-        }
+#ifdef __SIZEOF_INT128__
+    if (data_.size() <= 3 && rhs.data_.size() <= 3) {
+        // both magnitudes are below 2^96, so the sum fits in 128 bits
+        int128 sum = toInt128(data_, sign_) + toInt128(rhs.data_, rhs.sign_);
+        fromUint128(result.data_, int128Magnitude(sum));
+        result.sign_ = int128Sign(sum);
+        return result;
     }
+#endif  // __SIZEOF_INT128__
+    result.data_.reserve(std::max(data_.size(), rhs.data_.size()) + 1);
+    result.assign(*this);
+    result += rhs;
     return result;
 }
 
 BigInteger BigInteger::operator-(const BigInteger& rhs) const
 {
-    const BigInteger& lhs = *this;
     BigInteger result;
-    if (lhs.sign_ == 0)
-        return -rhs;
-    if (rhs.sign_ == 0)
-        return lhs;
-    if (lhs.sign_ != rhs.sign_) {
-        result = lhs.unsignedAdd_(rhs);
-        result.sign_ = lhs.sign_;
-    } else {
-        if (lhs.unsignedLessThan_(rhs)) {
-            result = rhs.unsignedSubtract_(lhs);
-            result.sign_ = -lhs.sign_;
-        } else {
-            result = lhs.unsignedSubtract_(rhs);
-            if (result.data_.size() == 1 && result.data_[0] == 0)
-                result.sign_ = 0;
-            else
-                result.sign_ = lhs.sign_;
-        }
+#ifdef __SIZEOF_INT128__
+    if (data_.size() <= 3 && rhs.data_.size() <= 3) {
+        int128 diff = toInt128(data_, sign_) - toInt128(rhs.data_, rhs.sign_);
+        fromUint128(result.data_, int128Magnitude(diff));
+        result.sign_ = int128Sign(diff);
+        return result;
     }
+#endif  // __SIZEOF_INT128__
+    result.data_.reserve(std::max(data_.size(), rhs.data_.size()) + 1);
+    result.assign(*this);
+    result -= rhs;
     return result;
 }
 
 BigInteger BigInteger::operator*(const BigInteger& rhs) const
 {
-    const std::vector<char> *longer, *shorter;
-    if (data_.size() < rhs.data_.size())
-        longer = &rhs.data_, shorter = &this->data_;
-    else
-        longer = &this->data_, shorter = &rhs.data_;
-    std::vector<char> prod(shorter->size() + longer->size(), 0);
-    for (size_t i = 0; i < shorter->size(); ++i) {
-        int carry = 0;
-        for (size_t j = 0; j < longer->size(); ++j) {
-            int p = (*longer)[j] * (*shorter)[i] + carry + prod[i + j];
-            prod[i + j] = p % 10;
-            carry = p / 10;
-        }
-        if (carry)
-            prod[i + longer->size()] = carry;
-    }
-    int size = prod.size();
-    for (auto it = prod.rbegin(); it != prod.rend() && *it == 0; ++it)
-        size -= 1;
-    if (size == 0)
-        size = 1;
-    prod.resize(size);
     BigInteger result;
-    result.data_ = prod;
+    if (sign_ == 0 || rhs.sign_ == 0)
+        return result;
+#ifdef __SIZEOF_INT128__
+    if (data_.size() <= 2 && rhs.data_.size() <= 2) {
+        fromUint128(result.data_, toUint128(data_) * toUint128(rhs.data_));
+        result.sign_ = sign_ * rhs.sign_;
+        return result;
+    }
+#endif  // __SIZEOF_INT128__
+    result.data_.resize(data_.size() + rhs.data_.size());
+    limbs::mul(result.data_.data(), data_.data(), data_.size(),
+               rhs.data_.data(), rhs.data_.size());
+    result.trim_();
     result.sign_ = sign_ * rhs.sign_;
     return result;
 }
 
 BigInteger BigInteger::operator/(const BigInteger& rhs) const
 {
-    throw std::runtime_error("Not implemented");
+    if (rhs.sign_ == 0)
+        throw std::runtime_error("division by zero.");
+    BigInteger result;
+    unsignedDivmod_(rhs.data_.data(), rhs.data_.size(), &result, nullptr);
+    if (!result.data_.empty())
+        result.sign_ = sign_ * rhs.sign_;
+    return result;
+}
+
+BigInteger BigInteger::operator%(const BigInteger& rhs) const
+{
+    if (rhs.sign_ == 0)
+        throw std::runtime_error("division by zero.");
+    BigInteger result;
+    unsignedDivmod_(rhs.data_.data(), rhs.data_.size(), nullptr, &result);
+    if (!result.data_.empty())
+        result.sign_ = sign_;
+    return result;
+}
+
+void BigInteger::divmod(const BigInteger& rhs, BigInteger& quotient,
+                        BigInteger& remainder) const
+{
+    if (rhs.sign_ == 0)
+        throw std::runtime_error("division by zero.");
+    // either output may alias an operand, so work on fresh values
+    BigInteger q, r;
+    unsignedDivmod_(rhs.data_.data(), rhs.data_.size(), &q, &r);
+    if (!q.data_.empty())
+        q.sign_ = sign_ * rhs.sign_;
+    if (!r.data_.empty())
+        r.sign_ = sign_;
+    quotient = std::move(q);
+    remainder = std::move(r);
+}
+
+BigInteger BigInteger::powMod(const BigInteger& exp,
+                              const BigInteger& mod) const
+{
+    return MontgomeryContext(mod).powMod(*this, exp);
 }
 
 BigInteger BigInteger::operator+(long long rhs) const
 {
-    return *this + BigInteger(rhs);
+    BigInteger result;
+    result.data_.reserve(std::max<size_t>(data_.size(), 2) + 1);
+    result.assign(*this);
+    result += rhs;
+    return result;
 }
 
 BigInteger BigInteger::operator-(long long rhs) const
 {
-    return *this - BigInteger(rhs);
+    BigInteger result;
+    result.data_.reserve(std::max<size_t>(data_.size(), 2) + 1);
+    result.assign(*this);
+    result -= rhs;
+    return result;
 }
 
 BigInteger BigInteger::operator*(long long rhs) const
 {
-    return *this * BigInteger(rhs);
+    BigInteger result;
+    result.data_.reserve(data_.size() + 2);
+    result.assign(*this);
+    result *= rhs;
+    return result;
 }
 
+// the divisor of the scalar division overloads goes straight to the limb
+//   kernels, which take a single-limb divisor on their fast path
 BigInteger BigInteger::operator/(long long rhs) const
 {
-    return *this / BigInteger(rhs);
+    BigInteger result = *this;
+    result /= rhs;
+    return result;
+}
+
+BigInteger BigInteger::operator%(long long rhs) const
+{
+    if (rhs == 0)
+        throw std::runtime_error("division by zero.");
+    limbs::limb_t divisor[2];
+    size_t len = scalarLimbs(rhs, divisor);
+    BigInteger result;
+    unsignedDivmod_(divisor, len, nullptr, &result);
+    if (!result.data_.empty())
+        result.sign_ = sign_;
+    return result;
+}
+
+
+// compound assignment operators
+BigInteger& BigInteger::operator+=(const BigInteger& rhs)
+{
+    if (&rhs == this) {
+        data_.push_back(0);
+        limbs::lshift(data_.data(), data_.data(), data_.size(), 1);
+        trim_();
+        return *this;
+    }
+    addSigned_(rhs.data_.data(), rhs.data_.size(), rhs.sign_);
+    return *this;
+}
+
+BigInteger& BigInteger::operator-=(const BigInteger& rhs)
+{
+    if (&rhs == this) {
+        assign(0LL);
+        return *this;
+    }
+    addSigned_(rhs.data_.data(), rhs.data_.size(), -rhs.sign_);
+    return *this;
+}
+
+BigInteger& BigInteger::operator*=(const BigInteger& rhs)
+{
+    if (sign_ == 0 || rhs.sign_ == 0) {
+        assign(0LL);
+        return *this;
+    }
+    mulLimbs_(rhs.data_.data(), rhs.data_.size());
+    sign_ *= rhs.sign_;
+    return *this;
+}
+
+BigInteger& BigInteger::operator/=(const BigInteger& rhs)
+{
+    return *this = *this / rhs;
+}
+
+BigInteger& BigInteger::operator%=(const BigInteger& rhs)
+{
+    return *this = *this % rhs;
+}
+
+BigInteger& BigInteger::operator+=(long long rhs)
+{
+    limbs::limb_t other[2];
+    size_t len = scalarLimbs(rhs, other);
+    addSigned_(other, len, scalarSign(rhs));
+    return *this;
+}
+
+BigInteger& BigInteger::operator-=(long long rhs)
+{
+    limbs::limb_t other[2];
+    size_t len = scalarLimbs(rhs, other);
+    addSigned_(other, len, -scalarSign(rhs));
+    return *this;
+}
+
+BigInteger& BigInteger::operator*=(long long rhs)
+{
+    if (sign_ == 0 || rhs == 0) {
+        assign(0LL);
+        return *this;
+    }
+    limbs::limb_t other[2];
+    size_t len = scalarLimbs(rhs, other);
+    if (len == 1) {
+        limbs::limb_t carry = limbs::mul_1(data_.data(), data_.data(),
+                                           data_.size(), other[0]);
+        if (carry)
+            data_.push_back(carry);
+    } else {
+        mulLimbs_(other, len);
+    }
+    sign_ *= scalarSign(rhs);
+    return *this;
+}
+
+BigInteger& BigInteger::operator/=(long long rhs)
+{
+    if (rhs == 0)
+        throw std::runtime_error("division by zero.");
+    limbs::limb_t divisor[2];
+    size_t len = scalarLimbs(rhs, divisor);
+    if (len == 1) {
+        limbs::divmod_1(data_.data(), data_.data(), data_.size(), divisor[0]);
+        trim_();
+    } else {
+        BigInteger quotient;
+        unsignedDivmod_(divisor, len, &quotient, nullptr);
+        data_.swap(quotient.data_);
+    }
+    sign_ = data_.empty() ? 0 : sign_ * scalarSign(rhs);
+    return *this;
+}
+
+BigInteger& BigInteger::operator%=(long long rhs)
+{
+    if (rhs == 0)
+        throw std::runtime_error("division by zero.");
+    limbs::limb_t divisor[2];
+    size_t len = scalarLimbs(rhs, divisor);
+    if (len == 1) {
+        limbs::limb_t rem = limbs::mod_1(data_.data(), data_.size(),
+                                         divisor[0]);
+        data_.assign(rem ? 1 : 0, rem);
+    } else {
+        BigInteger remainder;
+        unsignedDivmod_(divisor, len, nullptr, &remainder);
+        data_.swap(remainder.data_);
+    }
+    if (data_.empty())
+        sign_ = 0;
+    return *this;
 }
 
 bool BigInteger::operator<(const BigInteger& rhs) const
@@ -140,7 +448,10 @@ bool BigInteger::operator<(const BigInteger& rhs) const
 
 bool BigInteger::operator==(long long num) const
 {
-    return *this == BigInteger(num);
+    limbs::limb_t other[2];
+    size_t len = scalarLimbs(num, other);
+    return sign_ == scalarSign(num)
+           && limbs::cmp(data_.data(), data_.size(), other, len) == 0;
 }
 
 bool BigInteger::operator==(const BigInteger& rhs) const
@@ -152,28 +463,71 @@ bool BigInteger::operator==(const BigInteger& rhs) const
 // input/output operators
 std::istream& operator>>(std::istream& is, BigInteger& me)
 {
-    // currently only supports decimal input
+    // the radix follows the stream's basefield (or BigInteger::binary); with
+    //   none set, a 0x or 0b prefix picks it
     std::string str;
-    is >> str;
-    me.assign(str);
+    if (!(is >> str))
+        return is;
+    try {
+        me.assign(str, streamBase(is));
+    } catch (const std::runtime_error&) {
+        is.setstate(std::ios_base::failbit);
+    }
     return is;
 }
 
 std::ostream& operator<<(std::ostream& os, const BigInteger& me)
 {
-    os << me.toString();
+    int base = streamBase(os);
+    if (base == 0)
+        base = 10;
+    bool uppercase = os.flags() & std::ios_base::uppercase;
+    std::string prefix;
+    if (me.sign_ == -1)
+        prefix = "-";
+    else if (os.flags() & std::ios_base::showpos)
+        prefix = "+";
+    if ((os.flags() & std::ios_base::showbase) && me.sign_ != 0) {
+        if (base == 16)
+            prefix += uppercase ? "0X" : "0x";
+        else if (base == 8)
+            prefix += "0";
+        else if (base == 2)
+            prefix += "0b";
+    }
+    if (os.width() > 0) {
+        // padding needs the full length up front
+        std::string str = prefix;
+        me.writeDigits_(base, uppercase, [&str](const char* digits, size_t len) {
+            str.append(digits, len);
+        });
+        os << str;
+        return os;
+    }
+    os.write(prefix.data(), prefix.size());
+    me.writeDigits_(base, uppercase, [&os](const char* digits, size_t len) {
+        os.write(digits, len);
+    });
     return os;
 }
 
+std::ios_base& BigInteger::binary(std::ios_base& ios)
+{
+    ios.iword(binaryFlagIndex()) = 1;
+    ios.unsetf(std::ios_base::basefield);
+    return ios;
+}
+
 
 // accessors
-std::string BigInteger::toString() const
+std::string BigInteger::toString(int base) const
 {
     std::string result;
     if (sign_ == -1)
         result.push_back('-');
-    for (auto it = data_.rbegin(); it != data_.rend(); ++it)
-        result.push_back(*it + '0');
+    writeDigits_(base, false, [&result](const char* digits, size_t len) {
+        result.append(digits, len);
+    });
     return result;
 }
 
@@ -187,27 +541,22 @@ BigInteger BigInteger::abs() const
 
 int BigInteger::unsignedCompareTo(const BigInteger& rhs) const
 {
-    const std::vector<char> &l = this->data_, &r = rhs.data_;
-    assert(l.size() != 0 && r.size() != 0);
-    if (r.size() > l.size())
-        return -1;
-    if (l.size() > r.size())
-        return 1;
-    int len = l.size();
-    for (int i = len - 1; i >= 0; --i) {
-        if (l[i] < r[i])
-            return -1;
-        else if (l[i] > r[i])
-            return 1;
-    }
-    return 0;  // equal
+    const LimbVector &l = this->data_, &r = rhs.data_;
+    return limbs::cmp(l.data(), l.size(), r.data(), r.size());
 }
 
 int BigInteger::compareTo(const BigInteger& rhs) const
 {
     const BigInteger& lhs = *this;
+#ifdef __SIZEOF_INT128__
+    if (lhs.sign_ == rhs.sign_ && lhs.data_.size() <= 4
+        && rhs.data_.size() <= 4) {
+        uint128 l = toUint128(lhs.data_), r = toUint128(rhs.data_);
+        return lhs.sign_ * ((l > r) - (l < r));
+    }
+#endif  // __SIZEOF_INT128__
     if (lhs.sign_ == rhs.sign_)
-        return lhs.unsignedCompareTo(rhs);
+        return lhs.sign_ * lhs.unsignedCompareTo(rhs);
     else if (lhs.sign_ < rhs.sign_)
         return -1;
     else if (lhs.sign_ > rhs.sign_)
@@ -220,19 +569,21 @@ int BigInteger::compareTo(const BigInteger& rhs) const
 // modifiers
 void BigInteger::assign(long long num)
 {
+    data_.clear();
     if (num == 0) {
         sign_ = 0;
-        data_ = std::vector<char>{ 0 };
         return;
     }
     sign_ = 1;
+    // negate in unsigned arithmetic so that LLONG_MIN is handled
+    unsigned long long mag = num;
     if (num < 0) {
-        num = -num;
+        mag = -mag;
         sign_ = -1;
     }
-    while (num) {
-        data_.push_back(num % 10);
-        num /= 10;
+    while (mag) {
+        data_.push_back(static_cast<limbs::limb_t>(mag));
+        mag >>= limbs::LIMB_BITS;
     }
 }
 
@@ -242,94 +593,108 @@ void BigInteger::assign(const BigInteger& other)
     sign_ = other.sign_;
 }
 
-void BigInteger::assign(const std::string& str)
+void BigInteger::assign(const std::string& str, int base)
 {
-    BigInteger& me = *this;
     if (str.empty())
         throw std::runtime_error("str can't be empty.");
-    me.sign_ = 0;
-    int i = 0;
+    size_t i = 0;
+    int sign = 1;
     if (str[i] == '-') {
-        me.sign_ = -1;
+        sign = -1;
         ++i;
     } else if (str[i] == '+') {
-        me.sign_ = 1;
         ++i;
     }
+    auto has_prefix = [&str, i](char letter) {
+        return str.length() > i + 1 && str[i] == '0'
+               && (str[i + 1] | 0x20) == letter;
+    };
+    if ((base == 0 || base == 16) && has_prefix('x')) {
+        base = 16;
+        i += 2;
+    } else if ((base == 0 || base == 2) && has_prefix('b')) {
+        base = 2;
+        i += 2;
+    } else if (base == 0) {
+        base = 10;
+    }
+    int bits = radixBits(base);
+    if (base != 10 && bits == 0)
+        throw std::runtime_error("unsupported base.");
+
     // ignoring preceding zeros
-    while (str[i] && str[i] == '0')
+    while (i < str.length() && str[i] == '0')
         ++i;
-    if (!str[i]) {
-        me.data_ = std::vector<char>{ 0 };
-    } else {
-        if (me.sign_ != -1)
-            me.sign_ = 1;
-        for (int j = str.length() - 1; j >= i; --j)
-            me.data_.push_back(str[j] - '0');
+    for (size_t j = i; j < str.length(); ++j) {
+        if (digitValue(str[j]) >= base)
+            throw std::runtime_error("str contains an invalid digit.");
+    }
+    if (i == str.length()) {
+        assign(0LL);
+        return;
     }
+    std::vector<limbs::limb_t> mag = base == 10
+        ? limbs::from_decimal(str.data() + i, str.length() - i)
+        : limbs::from_radix_pow2(str.data() + i, str.length() - i, bits);
+    data_.assign(mag.data(), mag.data() + mag.size());
+    sign_ = sign;
 }
 
 
 // helper functions
-BigInteger BigInteger::unsignedAdd_(const BigInteger& rhs) const
+// adds the magnitude b[0, bn) carrying the sign `bsign` to this in place
+void BigInteger::addSigned_(const limbs::limb_t* b, size_t bn, int bsign)
 {
-    const std::vector<char> *longer, *shorter;
-    if (data_.size() < rhs.data_.size())
-        longer = &rhs.data_, shorter = &this->data_;
-    else
-        longer = &this->data_, shorter = &rhs.data_;
-    std::vector<char> sum;
-    int carry = 0;
-    for (size_t i = 0; i < shorter->size(); ++i) {
-        int s = carry + (*shorter)[i] + (*longer)[i];
-        if (s >= 10)
-            sum.push_back(s - 10), carry = 1;
-        else
-            sum.push_back(s), carry = 0;
+    if (bsign == 0)
+        return;
+    if (sign_ == 0) {
+        data_.assign(b, b + bn);
+        sign_ = bsign;
+        return;
     }
-    for (size_t i = shorter->size(); i < longer->size(); ++i) {
-        int s = carry + (*longer)[i];
-        if (s >= 10)
-            sum.push_back(s - 10), carry = 1;
+    size_t n = data_.size();
+    if (sign_ == bsign) {
+        data_.resize(std::max(n, bn) + 1);
+        limbs::limb_t* r = data_.data();
+        if (n >= bn)
+            r[n] = limbs::add(r, r, n, b, bn);
         else
-            sum.push_back(s), carry = 0;
+            r[bn] = limbs::add(r, b, bn, r, n);
+    } else if (limbs::cmp(data_.data(), n, b, bn) >= 0) {
+        limbs::sub(data_.data(), data_.data(), n, b, bn);
+    } else {
+        data_.resize(bn);
+        limbs::sub(data_.data(), b, bn, data_.data(), n);
+        sign_ = bsign;
     }
-    if (carry)
-        sum.push_back(carry);
-    BigInteger result;
-    result.data_ = sum;
-    return result;
+    trim_();
+    if (data_.empty())
+        sign_ = 0;
 }
 
-BigInteger BigInteger::unsignedSubtract_(const BigInteger& rhs) const
+// emits the digits of the magnitude in the given radix; zero is "0"
+void BigInteger::writeDigits_(int base, bool uppercase,
+                              const limbs::DigitSink& sink) const
 {
-    // we already know that the lhs is longer
-    const std::vector<char> &l = this->data_, &r = rhs.data_;
-    std::vector<char> diff;
-    int carry = 0;
-    for (size_t i = 0; i < r.size(); ++i) {
-        int s = carry + (l[i] - r[i]);
-        if (s < 0)
-            diff.push_back(s + 10), carry = -1;
-        else
-            diff.push_back(s), carry = 0;
-    }
-    for (size_t i = r.size(); i < l.size(); ++i) {
-        int s = carry + l[i];
-        if (s < 0)
-            diff.push_back(s + 10), carry = -1;
-        else
-            diff.push_back(s), carry = 0;
-    }
-    int size = diff.size();
-    for (auto it = diff.rbegin(); it != diff.rend() && *it == 0; ++it)
-        size -= 1;
-    if (size == 0)
-        size = 1;
-    diff.resize(size);
-    BigInteger result;
-    result.data_ = diff;
-    return result;
+    int bits = radixBits(base);
+    if (base != 10 && bits == 0)
+        throw std::runtime_error("unsupported base.");
+    if (sign_ == 0)
+        sink("0", 1);
+    else if (base == 10)
+        limbs::to_decimal(data_.data(), data_.size(), sink);
+    else
+        limbs::to_radix_pow2(data_.data(), data_.size(), bits, uppercase, sink);
+}
+
+// multiplies the magnitude by b[0, bn) in place, through the scratch space
+void BigInteger::mulLimbs_(const limbs::limb_t* b, size_t bn)
+{
+    std::vector<limbs::limb_t>& product = scratch();
+    product.resize(data_.size() + bn);
+    limbs::mul(product.data(), data_.data(), data_.size(), b, bn);
+    size_t len = limbs::normalized_size(product.data(), product.size());
+    data_.assign(product.data(), product.data() + len);
 }
 
 bool BigInteger::unsignedLessThan_(const BigInteger& rhs) const
@@ -337,3 +702,51 @@ bool BigInteger::unsignedLessThan_(const BigInteger& rhs) const
     return this->unsignedCompareTo(rhs) == -1;
 }
 
+// divides the magnitude by divisor[0, divisor_len), which is normalized and
+//   non-zero; the results are left unsigned (sign 1, or 0 when zero)
+void BigInteger::unsignedDivmod_(const limbs::limb_t* divisor,
+                                 size_t divisor_len, BigInteger* quotient,
+                                 BigInteger* remainder) const
+{
+    size_t len = data_.size();
+    if (len < divisor_len
+        || limbs::cmp(data_.data(), len, divisor, divisor_len) < 0) {
+        if (quotient)
+            quotient->assign(0LL);
+        if (remainder)
+            remainder->assign(*this);
+    } else {
+        if (quotient)
+            quotient->data_.resize(len - divisor_len + 1);
+        if (remainder)
+            remainder->data_.resize(divisor_len);
+        limbs::divmod(quotient ? quotient->data_.data() : nullptr,
+                      remainder ? remainder->data_.data() : nullptr,
+                      data_.data(), len, divisor, divisor_len);
+        if (quotient)
+            quotient->trim_();
+        if (remainder)
+            remainder->trim_();
+    }
+    if (quotient)
+        quotient->sign_ = quotient->data_.empty() ? 0 : 1;
+    if (remainder)
+        remainder->sign_ = remainder->data_.empty() ? 0 : 1;
+}
+
+BigInteger BigInteger::productTree_(std::vector<BigInteger>& factors)
+{
+    if (factors.empty())
+        return 1;
+    std::vector<size_t> ends(factors.size() + 1, 0);
+    for (size_t i = 0; i < factors.size(); ++i)
+        ends[i + 1] = ends[i] + factors[i].data_.size();
+    multiplyRange(factors, ends, 0, factors.size());
+    return std::move(factors[0]);
+}
+
+void BigInteger::trim_()
+{
+    data_.resize(limbs::normalized_size(data_.data(), data_.size()));
+}
+
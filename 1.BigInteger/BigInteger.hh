@@ -1,15 +1,20 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <vector>
 #include <string>
 
+#include "LimbVector.hh"
+#include "Limbs.hh"
+
 class BigInteger
 {
   public:
     // constructors
     BigInteger() = default;
     BigInteger(const BigInteger& other) = default;
+    BigInteger(BigInteger&& other) noexcept;
     BigInteger(int num);
     BigInteger(const std::string& str);
 
@@ -18,16 +23,48 @@ class BigInteger
 
     // binary operators
     BigInteger& operator=(const BigInteger& other) = default;
+    BigInteger& operator=(BigInteger&& other) noexcept;
 
     BigInteger operator+(const BigInteger& rhs) const;
     BigInteger operator-(const BigInteger& rhs) const;
     BigInteger operator*(const BigInteger& rhs) const;
     BigInteger operator/(const BigInteger& rhs) const;
+    BigInteger operator%(const BigInteger& rhs) const;
 
     BigInteger operator+(long long rhs) const;
     BigInteger operator-(long long rhs) const;
     BigInteger operator*(long long rhs) const;
     BigInteger operator/(long long rhs) const;
+    BigInteger operator%(long long rhs) const;
+
+    // division truncates towards zero, and the remainder takes the sign of
+    //   the dividend, as with the built-in integers
+    void divmod(const BigInteger& rhs, BigInteger& quotient,
+                BigInteger& remainder) const;
+
+    // this^exp mod `mod`, in [0, mod), for a non-negative exp and a positive
+    //   mod. Each call sets up a MontgomeryContext; keep one around instead
+    //   when exponentiating repeatedly against the same modulus.
+    BigInteger powMod(const BigInteger& exp, const BigInteger& mod) const;
+
+    // the product of the values in [first, last), or 1 for an empty range,
+    //   multiplied as a balanced tree whose branches run in parallel
+    template <typename Iterator>
+    static BigInteger product(Iterator first, Iterator last);
+
+    // compound assignment operators; these work in place and reuse the
+    //   existing capacity whenever the result fits in it
+    BigInteger& operator+=(const BigInteger& rhs);
+    BigInteger& operator-=(const BigInteger& rhs);
+    BigInteger& operator*=(const BigInteger& rhs);
+    BigInteger& operator/=(const BigInteger& rhs);
+    BigInteger& operator%=(const BigInteger& rhs);
+
+    BigInteger& operator+=(long long rhs);
+    BigInteger& operator-=(long long rhs);
+    BigInteger& operator*=(long long rhs);
+    BigInteger& operator/=(long long rhs);
+    BigInteger& operator%=(long long rhs);
 
     bool operator<(const BigInteger& rhs) const;
 
@@ -35,29 +72,68 @@ class BigInteger
     bool operator==(long long num) const;
     bool operator==(const BigInteger& rhs) const;
 
-    // input/output operators
+    // input/output operators; these follow std::hex, std::oct and std::dec,
+    //   plus BigInteger::binary, and output is streamed without building the
+    //   whole string first
     friend std::istream& operator>>(std::istream& is, BigInteger& me);
     friend std::ostream& operator<<(std::ostream& os, const BigInteger& me);
+    static std::ios_base& binary(std::ios_base& ios);
 
     // accessors
-    std::string toString() const;
+    //   base is one of 2, 8, 10 and 16
+    std::string toString(int base = 10) const;
     BigInteger abs() const;
+    //   the greatest common divisor of the magnitudes, never negative
+    BigInteger gcd(const BigInteger& rhs) const;
+    //   the same, also setting x and y so that this x + rhs y == gcd
+    BigInteger extendedGcd(const BigInteger& rhs, BigInteger& x,
+                           BigInteger& y) const;
+    //   the inverse modulo a positive mod, in [0, mod); throws if the two
+    //   are not coprime
+    BigInteger modInverse(const BigInteger& mod) const;
+    //   the k-th root truncated towards zero; even roots of negative
+    //   values throw
+    BigInteger isqrt() const;
+    BigInteger iroot(int k) const;
     int unsignedCompareTo(const BigInteger& rhs) const;
     int compareTo(const BigInteger& rhs) const;
 
     // modifiers
     void assign(long long num);
     void assign(const BigInteger& other);
-    void assign(const std::string& str);
+    //   base is one of 2, 8, 10 and 16, or 0 to pick it from a 0x or 0b prefix
+    void assign(const std::string& str, int base = 10);
 
   private:
-    // underlying data
-    std::vector<char> data_;
-    int sign_;
+    friend class MontgomeryContext;
+
+    // underlying data: the magnitude as little-endian binary limbs, without
+    //   leading zero limbs (so zero is the empty vector), and the sign.
+    //   Values of up to 128 bits are stored inline.
+    LimbVector data_;
+    int sign_ = 0;
 
     // helper functions
-    BigInteger unsignedAdd_(const BigInteger& rhs) const;
-    BigInteger unsignedSubtract_(const BigInteger& rhs) const;
+    void addSigned_(const limbs::limb_t* b, size_t bn, int bsign);
+    void mulLimbs_(const limbs::limb_t* b, size_t bn);
+    void writeDigits_(int base, bool uppercase,
+                      const limbs::DigitSink& sink) const;
     bool unsignedLessThan_(const BigInteger& rhs) const;
+    void unsignedDivmod_(const limbs::limb_t* divisor, size_t divisor_len,
+                         BigInteger* quotient, BigInteger* remainder) const;
+    void trim_();
+    size_t bitLength_() const;
+    BigInteger shifted_(long bits) const;
+    BigInteger& assignUnsigned_(std::uint64_t num);
+    static BigInteger lehmerGcd_(BigInteger a, BigInteger b,
+                                 BigInteger* cofactor);
+    static BigInteger productTree_(std::vector<BigInteger>& factors);
 };
 
+template <typename Iterator>
+BigInteger BigInteger::product(Iterator first, Iterator last)
+{
+    std::vector<BigInteger> factors(first, last);
+    return productTree_(factors);
+}
+
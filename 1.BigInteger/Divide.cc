@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "Limbs.hh"
+
+// Division: a single-limb path, Knuth's Algorithm D, and for long operands
+//   a Barrett-style block division by a reciprocal computed with Newton's
+//   iteration, so that its cost follows that of multiplication.
+namespace limbs
+{
+
+size_t div_newton_threshold = 3072;
+
+namespace
+{
+
+using Limbs = std::vector<limb_t>;
+
+// Knuth's Algorithm D (TAOCP 4.3.1). `v` is normalized (its top bit is set)
+//   and the top n limbs of u[0, un) are less than `v`. Leaves the quotient in
+//   q[0, un - n) and the remainder in u[0, n).
+void divmod_knuth(limb_t* q, limb_t* u, size_t un, const limb_t* v, size_t n)
+{
+    assert(n >= 2 && (v[n - 1] >> (LIMB_BITS - 1)));
+    const dlimb_t base = dlimb_t(1) << LIMB_BITS;
+    for (size_t j = un - n; j-- > 0; ) {
+        dlimb_t num = (static_cast<dlimb_t>(u[j + n]) << LIMB_BITS)
+                      | u[j + n - 1];
+        dlimb_t qhat = num / v[n - 1], rhat = num % v[n - 1];
+        while (qhat >= base || qhat * v[n - 2]
+                               > ((rhat << LIMB_BITS) | u[j + n - 2])) {
+            --qhat;
+            rhat += v[n - 1];
+            if (rhat >= base)
+                break;
+        }
+        limb_t borrow = submul_1(u + j, v, n, static_cast<limb_t>(qhat));
+        limb_t top = u[j + n];
+        u[j + n] = top - borrow;
+        if (top < borrow) {
+            // the estimate was one too large; add the divisor back
+            --qhat;
+            u[j + n] += add_n(u + j, u + j, v, n);
+        }
+        q[j] = static_cast<limb_t>(qhat);
+    }
+}
+
+// returns floor(B^(2n) / v) in n + 1 limbs, for a normalized `v`, where B is
+//   the limb base. `exact` asks for the correction step at the end; the
+//   recursive calls do without it and only guarantee an underestimate.
+Limbs reciprocal(const limb_t* v, size_t n, bool exact)
+{
+    Limbs x(n + 1);
+    if (n < std::max<size_t>(div_newton_threshold, 8)) {
+        Limbs u(2 * n + 1, 0);
+        u[2 * n] = 1;
+        divmod_knuth(x.data(), u.data(), u.size(), v, n);
+        return x;
+    }
+
+    // Lift the reciprocal of the top h limbs, lowered by 4 so that it stays
+    //   an underestimate, then do one Newton step
+    //     x += x * (B^(2n) - v x) / B^(2n).
+    //   Each step squares the relative error; with h a little over n / 2
+    //   the truncation error stays within a few units.
+    size_t h = (n + 1) / 2 + 1;
+    Limbs xh = reciprocal(v + n - h, h, false);
+    sub_1(xh.data(), xh.data(), xh.size(), 4);
+    std::copy(xh.begin(), xh.end(), x.begin() + (n - h));
+
+    Limbs p(2 * n + 1);
+    mul(p.data(), v, n, x.data(), n + 1);
+    // x <= B^(2n) / v, so p <= B^(2n) and the residual fits in 2n limbs
+    Limbs resid(2 * n, 0);
+    if (p[2 * n] == 0)
+        sub_n(resid.data(), resid.data(), p.data(), 2 * n);
+    size_t rn = normalized_size(resid.data(), resid.size());
+
+    if (rn) {
+        Limbs t(n + 1 + rn);
+        mul(t.data(), x.data(), n + 1, resid.data(), rn);
+        if (t.size() > 2 * n)
+            add(x.data(), x.data(), n + 1, t.data() + 2 * n, t.size() - 2 * n);
+    }
+
+    if (exact) {
+        // the residual of the final x is below a few multiples of `v`
+        mul(p.data(), v, n, x.data(), n + 1);
+        std::fill(resid.begin(), resid.end(), 0);
+        resid.push_back(1);
+        sub(resid.data(), resid.data(), resid.size(), p.data(), p.size());
+        while (normalized_size(resid.data() + n, n + 1)
+               || cmp_n(resid.data(), v, n) >= 0) {
+            sub(resid.data(), resid.data(), resid.size(), v, n);
+            add_1(x.data(), x.data(), n + 1, 1);
+        }
+    }
+    return x;
+}
+
+// divides the window w[0, n + len) < v B^len by the normalized `v` using
+//   its reciprocal `inv`; leaves the quotient in q[0, len) and the remainder
+//   in w[0, n)
+void divmod_block(limb_t* q, limb_t* w, size_t len, const limb_t* v,
+                  size_t n, const Limbs& inv)
+{
+    // qhat = floor(floor(w / B^(n-1)) * inv / B^(n+1)) is at most two below
+    //   the true quotient, and never above it
+    Limbs t(len + 1 + n + 1);
+    mul(t.data(), w + n - 1, len + 1, inv.data(), n + 1);
+    std::copy(t.begin() + n + 1, t.begin() + n + 1 + len, q);
+    assert(t[n + 1 + len] == 0);
+
+    Limbs p(len + n);
+    mul(p.data(), q, len, v, n);
+    limb_t borrow = sub_n(w, w, p.data(), len + n);
+    assert(borrow == 0);
+    (void)borrow;
+    while (normalized_size(w + n, len) || cmp_n(w, v, n) >= 0) {
+        sub(w, w, len + n, v, n);
+        add_1(q, q, len, 1);
+    }
+}
+
+// the same contract as divmod_knuth, for long divisors and quotients, given
+//   the exact reciprocal of `v`
+void divmod_newton(limb_t* q, limb_t* u, size_t un, const limb_t* v, size_t n,
+                   const Limbs& inv)
+{
+    // peel off quotient blocks of up to n limbs from the top, keeping the
+    //   running remainder in place in `u`
+    size_t j = un - n;
+    while (j > 0) {
+        size_t len = std::min(n, j);
+        j -= len;
+        divmod_block(q + j, u + j, len, v, n, inv);
+    }
+}
+
+PreparedDivisor prepare(const limb_t* d, size_t dn, bool with_inverse)
+{
+    assert(dn > 0 && d[dn - 1] != 0);
+    PreparedDivisor prepared;
+    prepared.shift = count_leading_zeros(d[dn - 1]);
+    prepared.v.resize(dn);
+    lshift(prepared.v.data(), d, dn, prepared.shift);
+    if (with_inverse)
+        prepared.inv = reciprocal(prepared.v.data(), dn, true);
+    return prepared;
+}
+
+}  // namespace
+
+PreparedDivisor prepare_divisor(const limb_t* d, size_t dn)
+{
+    return prepare(d, dn, dn >= 2 && dn >= div_newton_threshold);
+}
+
+void divmod(limb_t* q, limb_t* r, const limb_t* a, size_t an,
+            const PreparedDivisor& d)
+{
+    size_t dn = d.v.size();
+    assert(an >= dn && dn > 0);
+    size_t qn = an - dn + 1;
+    Limbs qq(qn);
+    if (dn == 1) {
+        limb_t rem = divmod_1(qq.data(), a, an, d.v[0] >> d.shift);
+        if (q)
+            std::copy(qq.begin(), qq.end(), q);
+        if (r)
+            r[0] = rem;
+        return;
+    }
+
+    Limbs u(an + 1);
+    u[an] = lshift(u.data(), a, an, d.shift);
+
+    if (!d.inv.empty() && qn >= div_newton_threshold)
+        divmod_newton(qq.data(), u.data(), u.size(), d.v.data(), dn, d.inv);
+    else
+        divmod_knuth(qq.data(), u.data(), u.size(), d.v.data(), dn);
+
+    if (q)
+        std::copy(qq.begin(), qq.end(), q);
+    if (r)
+        rshift(r, u.data(), dn, d.shift);
+}
+
+void divmod(limb_t* q, limb_t* r, const limb_t* a, size_t an,
+            const limb_t* d, size_t dn)
+{
+    assert(an >= dn && dn > 0 && d[dn - 1] != 0);
+    bool newton = dn >= 2 && dn >= div_newton_threshold
+                  && an - dn + 1 >= div_newton_threshold;
+    divmod(q, r, a, an, prepare(d, dn, newton));
+}
+
+}  // namespace limbs
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "Limbs.hh"
+
+// A vector of limbs with a small-buffer optimization: up to INLINE_LIMBS
+//   limbs (128 bits) live inside the object, and only longer values spill to
+//   the heap. Growing past the inline buffer moves the limbs to the heap
+//   once; shrinking never moves them back, so capacity is kept for reuse.
+class LimbVector
+{
+  public:
+    using limb_t = limbs::limb_t;
+    static const size_t INLINE_LIMBS = 4;
+
+    // constructors
+    LimbVector() noexcept
+        : size_(0), capacity_(INLINE_LIMBS)
+    {
+    }
+    LimbVector(const LimbVector& other)
+        : LimbVector()
+    {
+        assign(other.data(), other.data() + other.size());
+    }
+    LimbVector(LimbVector&& other) noexcept
+        : LimbVector()
+    {
+        steal_(other);
+    }
+    ~LimbVector()
+    {
+        if (!isInline())
+            std::free(heap_);
+    }
+
+    // assignment operators
+    LimbVector& operator=(const LimbVector& other)
+    {
+        if (&other != this)
+            assign(other.data(), other.data() + other.size());
+        return *this;
+    }
+    LimbVector& operator=(LimbVector&& other) noexcept
+    {
+        if (&other != this) {
+            if (!isInline())
+                std::free(heap_);
+            size_ = 0;
+            capacity_ = INLINE_LIMBS;
+            steal_(other);
+        }
+        return *this;
+    }
+
+    bool operator==(const LimbVector& other) const
+    {
+        return size_ == other.size_
+               && std::equal(begin(), end(), other.begin());
+    }
+
+    // accessors
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+    bool isInline() const { return capacity_ == INLINE_LIMBS; }
+
+    limb_t* data() { return isInline() ? inline_ : heap_; }
+    const limb_t* data() const { return isInline() ? inline_ : heap_; }
+    limb_t* begin() { return data(); }
+    limb_t* end() { return data() + size_; }
+    const limb_t* begin() const { return data(); }
+    const limb_t* end() const { return data() + size_; }
+
+    limb_t& operator[](size_t i) { return data()[i]; }
+    limb_t operator[](size_t i) const { return data()[i]; }
+    limb_t& back() { return data()[size_ - 1]; }
+    limb_t back() const { return data()[size_ - 1]; }
+
+    // modifiers
+    void reserve(size_t n)
+    {
+        if (n <= capacity_)
+            return;
+        limb_t* heap = static_cast<limb_t*>(std::malloc(n * sizeof(limb_t)));
+        if (!heap)
+            throw std::bad_alloc();
+        std::memcpy(heap, data(), size_ * sizeof(limb_t));
+        if (!isInline())
+            std::free(heap_);
+        heap_ = heap;
+        capacity_ = static_cast<std::uint32_t>(n);
+    }
+
+    // new limbs are zeroed, like std::vector::resize
+    void resize(size_t n)
+    {
+        if (n > capacity_)
+            reserve(std::max(n, 2 * static_cast<size_t>(capacity_)));
+        if (n > size_)
+            std::memset(data() + size_, 0, (n - size_) * sizeof(limb_t));
+        size_ = static_cast<std::uint32_t>(n);
+    }
+
+    void clear() { size_ = 0; }
+
+    void push_back(limb_t limb)
+    {
+        if (size_ == capacity_)
+            reserve(2 * static_cast<size_t>(capacity_));
+        data()[size_++] = limb;
+    }
+
+    void assign(const limb_t* first, const limb_t* last)
+    {
+        size_t n = last - first;
+        if (n > capacity_) {
+            size_ = 0;
+            reserve(n);
+        }
+        std::memmove(data(), first, n * sizeof(limb_t));
+        size_ = static_cast<std::uint32_t>(n);
+    }
+
+    void assign(size_t n, limb_t limb)
+    {
+        if (n > capacity_) {
+            size_ = 0;
+            reserve(n);
+        }
+        std::fill(data(), data() + n, limb);
+        size_ = static_cast<std::uint32_t>(n);
+    }
+
+    void swap(LimbVector& other) noexcept
+    {
+        LimbVector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+  private:
+    union {
+        limb_t* heap_;
+        limb_t inline_[INLINE_LIMBS];
+    };
+    std::uint32_t size_;
+    std::uint32_t capacity_;
+
+    // takes over the limbs of `other`, an empty inline vector being assumed
+    //   for this one, and leaves `other` empty
+    void steal_(LimbVector& other) noexcept
+    {
+        if (other.isInline()) {
+            std::memcpy(inline_, other.inline_, other.size_ * sizeof(limb_t));
+        } else {
+            heap_ = other.heap_;
+            capacity_ = other.capacity_;
+            other.capacity_ = INLINE_LIMBS;
+        }
+        size_ = other.size_;
+        other.size_ = 0;
+    }
+};
@@ -0,0 +1,168 @@
+#include "Limbs.hh"
+
+namespace limbs
+{
+
+size_t normalized_size(const limb_t* a, size_t n)
+{
+    while (n > 0 && a[n - 1] == 0)
+        --n;
+    return n;
+}
+
+int cmp(const limb_t* a, size_t an, const limb_t* b, size_t bn)
+{
+    if (an != bn)
+        return an < bn ? -1 : 1;
+    return cmp_n(a, b, an);
+}
+
+limb_t add(limb_t* r, const limb_t* a, size_t an, const limb_t* b, size_t bn)
+{
+    limb_t carry = add_n(r, a, b, bn);
+    return add_1(r + bn, a + bn, an - bn, carry);
+}
+
+limb_t add_1(limb_t* r, const limb_t* a, size_t n, limb_t b)
+{
+    size_t i = 0;
+    for (; i < n && b; ++i) {
+        limb_t s = a[i] + b;
+        b = s < b;
+        r[i] = s;
+    }
+    if (r != a) {
+        for (; i < n; ++i)
+            r[i] = a[i];
+    }
+    return b;
+}
+
+limb_t sub(limb_t* r, const limb_t* a, size_t an, const limb_t* b, size_t bn)
+{
+    limb_t borrow = sub_n(r, a, b, bn);
+    return sub_1(r + bn, a + bn, an - bn, borrow);
+}
+
+limb_t sub_1(limb_t* r, const limb_t* a, size_t n, limb_t b)
+{
+    size_t i = 0;
+    for (; i < n && b; ++i) {
+        limb_t x = a[i];
+        r[i] = x - b;
+        b = x < b;
+    }
+    if (r != a) {
+        for (; i < n; ++i)
+            r[i] = a[i];
+    }
+    return b;
+}
+
+limb_t mul_1(limb_t* r, const limb_t* a, size_t n, limb_t b)
+{
+    dlimb_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        carry += static_cast<dlimb_t>(a[i]) * b;
+        r[i] = static_cast<limb_t>(carry);
+        carry >>= LIMB_BITS;
+    }
+    return static_cast<limb_t>(carry);
+}
+
+limb_t addmul_1(limb_t* r, const limb_t* a, size_t n, limb_t b)
+{
+    dlimb_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        // a * b + r + carry < 2^64, so this never overflows
+        carry += static_cast<dlimb_t>(a[i]) * b + r[i];
+        r[i] = static_cast<limb_t>(carry);
+        carry >>= LIMB_BITS;
+    }
+    return static_cast<limb_t>(carry);
+}
+
+limb_t submul_1(limb_t* r, const limb_t* a, size_t n, limb_t b)
+{
+    dlimb_t borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+        dlimb_t p = static_cast<dlimb_t>(a[i]) * b + borrow;
+        limb_t lo = static_cast<limb_t>(p);
+        borrow = (p >> LIMB_BITS) + (r[i] < lo);
+        r[i] -= lo;
+    }
+    return static_cast<limb_t>(borrow);
+}
+
+limb_t lshift(limb_t* r, const limb_t* a, size_t n, int shift)
+{
+    if (shift == 0) {
+        if (r != a)
+            for (size_t i = 0; i < n; ++i)
+                r[i] = a[i];
+        return 0;
+    }
+    limb_t out = 0;
+    for (size_t i = 0; i < n; ++i) {
+        limb_t x = a[i];
+        r[i] = (x << shift) | out;
+        out = x >> (LIMB_BITS - shift);
+    }
+    return out;
+}
+
+limb_t rshift(limb_t* r, const limb_t* a, size_t n, int shift)
+{
+    if (shift == 0) {
+        if (r != a)
+            for (size_t i = 0; i < n; ++i)
+                r[i] = a[i];
+        return 0;
+    }
+    limb_t out = 0;
+    while (n-- > 0) {
+        limb_t x = a[n];
+        r[n] = (x >> shift) | out;
+        out = x << (LIMB_BITS - shift);
+    }
+    return out;
+}
+
+int count_leading_zeros(limb_t x)
+{
+    return __builtin_clz(x);
+}
+
+void mul_basecase(limb_t* r, const limb_t* a, size_t an,
+                  const limb_t* b, size_t bn)
+{
+    if (an == 0 || bn == 0) {
+        for (size_t i = 0; i < an + bn; ++i)
+            r[i] = 0;
+        return;
+    }
+    r[an] = mul_1(r, a, an, b[0]);
+    for (size_t j = 1; j < bn; ++j)
+        r[an + j] = addmul_1(r + j, a, an, b[j]);
+}
+
+limb_t divmod_1(limb_t* q, const limb_t* a, size_t n, limb_t d)
+{
+    dlimb_t rem = 0;
+    while (n-- > 0) {
+        dlimb_t cur = (rem << LIMB_BITS) | a[n];
+        q[n] = static_cast<limb_t>(cur / d);
+        rem = cur % d;
+    }
+    return static_cast<limb_t>(rem);
+}
+
+limb_t mod_1(const limb_t* a, size_t n, limb_t d)
+{
+    dlimb_t rem = 0;
+    while (n-- > 0)
+        rem = ((rem << LIMB_BITS) | a[n]) % d;
+    return static_cast<limb_t>(rem);
+}
+
+}  // namespace limbs
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Low-level kernels operating on little-endian arrays of binary limbs.
+//   Unless stated otherwise, `r` may alias `a` or `b` exactly (but not
+//   partially overlap them), and lengths are in limbs.
+namespace limbs
+{
+
+using limb_t = std::uint32_t;
+using dlimb_t = std::uint64_t;
+
+const int LIMB_BITS = 32;
+const limb_t LIMB_MAX = 0xffffffffu;
+
+// the largest power of ten fitting in a limb, used at the decimal boundary
+const limb_t DECIMAL_BASE = 1000000000u;
+const int DECIMAL_DIGITS = 9;
+
+// cmp_n, add_n and sub_n have SIMD versions, and the widest one the CPU
+//   supports is used unless set_simd_level picks another; it returns false
+//   for a level the CPU lacks
+enum class SimdLevel { scalar, sse42, avx2, avx512 };
+SimdLevel simd_level();
+bool set_simd_level(SimdLevel level);
+
+// returns `n` minus the number of leading zero limbs of `a`
+size_t normalized_size(const limb_t* a, size_t n);
+
+// compares a[0, n) and b[0, n); returns -1, 0 or 1
+int cmp_n(const limb_t* a, const limb_t* b, size_t n);
+// compares two normalized numbers of possibly different lengths
+int cmp(const limb_t* a, size_t an, const limb_t* b, size_t bn);
+
+// r[0, n) = a[0, n) + b[0, n); returns the carry out
+limb_t add_n(limb_t* r, const limb_t* a, const limb_t* b, size_t n);
+// r[0, an) = a[0, an) + b[0, bn), where an >= bn; returns the carry out
+limb_t add(limb_t* r, const limb_t* a, size_t an, const limb_t* b, size_t bn);
+// r[0, n) = a[0, n) + b; returns the carry out
+limb_t add_1(limb_t* r, const limb_t* a, size_t n, limb_t b);
+
+// r[0, n) = a[0, n) - b[0, n); returns the borrow out
+limb_t sub_n(limb_t* r, const limb_t* a, const limb_t* b, size_t n);
+// r[0, an) = a[0, an) - b[0, bn), where an >= bn; returns the borrow out
+limb_t sub(limb_t* r, const limb_t* a, size_t an, const limb_t* b, size_t bn);
+// r[0, n) = a[0, n) - b; returns the borrow out
+limb_t sub_1(limb_t* r, const limb_t* a, size_t n, limb_t b);
+
+// r[0, n) = a[0, n) * b; returns the high limb
+limb_t mul_1(limb_t* r, const limb_t* a, size_t n, limb_t b);
+// r[0, n) += a[0, n) * b; returns the high limb
+limb_t addmul_1(limb_t* r, const limb_t* a, size_t n, limb_t b);
+// r[0, n) -= a[0, n) * b; returns the high limb of the amount borrowed
+limb_t submul_1(limb_t* r, const limb_t* a, size_t n, limb_t b);
+
+// r[0, n) = a[0, n) << shift, for 0 <= shift < LIMB_BITS; returns the bits
+//   shifted out. `r` may alias `a`.
+limb_t lshift(limb_t* r, const limb_t* a, size_t n, int shift);
+// r[0, n) = a[0, n) >> shift, for 0 <= shift < LIMB_BITS; returns the bits
+//   shifted out, in the high end of the limb. `r` may alias `a`.
+limb_t rshift(limb_t* r, const limb_t* a, size_t n, int shift);
+// the number of leading zero bits of a non-zero limb
+int count_leading_zeros(limb_t x);
+
+// r[0, an + bn) = a * b; `r` must not overlap the operands
+void mul_basecase(limb_t* r, const limb_t* a, size_t an,
+                  const limb_t* b, size_t bn);
+
+// crossover points (in limbs of the shorter operand) between the
+//   multiplication algorithms; tune them with `mul_thresholds`
+struct MulThresholds
+{
+    size_t karatsuba = 32;  // schoolbook below this
+    size_t toom3 = 256;     // Karatsuba below this
+    size_t ntt = 32768;     // Toom-3 below this, the NTT from here on
+};
+extern MulThresholds mul_thresholds;
+
+// Products whose shorter operand has at least `parallel_grain` limbs fork
+//   their subproducts onto a pool of threads. set_threads counts the
+//   calling thread, so 1 keeps all work on it; the default is the hardware
+//   concurrency. It must not be called while a multiplication is running.
+extern size_t parallel_grain;
+void set_threads(size_t threads);
+size_t threads();
+
+// r[0, an + bn) = a * b, picking the algorithm by operand size. `r` must not
+//   overlap the operands; the operands may be given in either order.
+void mul(limb_t* r, const limb_t* a, size_t an, const limb_t* b, size_t bn);
+// r[0, 2n) = a * a; `r` must not overlap `a`
+void sqr(limb_t* r, const limb_t* a, size_t n);
+
+// q[0, n) = a[0, n) / d; returns the remainder. `q` may alias `a`.
+limb_t divmod_1(limb_t* q, const limb_t* a, size_t n, limb_t d);
+// returns a[0, n) % d
+limb_t mod_1(const limb_t* a, size_t n, limb_t d);
+
+// the divisor length (in limbs) from which division switches from Knuth's
+//   Algorithm D to multiplying by a Newton-iterated reciprocal; the quotient
+//   has to be at least this long too
+extern size_t div_newton_threshold;
+
+// q[0, an - dn + 1) = a / d and r[0, dn) = a % d, where an >= dn and the
+//   top limb of `d` is non-zero. The outputs must not overlap the inputs;
+//   either of them may be null when it is not wanted.
+void divmod(limb_t* q, limb_t* r, const limb_t* a, size_t an,
+            const limb_t* d, size_t dn);
+
+// a divisor normalized once, along with its reciprocal when it is long
+//   enough for the Newton path, for dividing many numbers by it
+struct PreparedDivisor
+{
+    std::vector<limb_t> v;    // shifted so that the top bit is set
+    std::vector<limb_t> inv;  // floor(B^(2n) / v), or empty
+    int shift;
+};
+PreparedDivisor prepare_divisor(const limb_t* d, size_t dn);
+// the same contract as divmod above, with dn = d.v.size()
+void divmod(limb_t* q, limb_t* r, const limb_t* a, size_t an,
+            const PreparedDivisor& d);
+
+// Modular multiplication of n-limb residues modulo m[0, n), where the top
+//   limb of `m` is non-zero and the operands are below `m`. The results may
+//   alias the operands.
+
+// returns -1 / m0 mod B, for an odd m0
+limb_t mont_n0inv(limb_t m0);
+// r[0, n) = t / B^n mod m, for t[0, 2n) < m B^n; `t` is overwritten
+void mont_redc(limb_t* r, limb_t* t, const limb_t* m, size_t n, limb_t n0inv);
+// r[0, n) = a b / B^n mod m, for an odd `m`
+void mont_mul(limb_t* r, const limb_t* a, const limb_t* b, const limb_t* m,
+              size_t n, limb_t n0inv);
+// returns floor(B^(2n) / m), normalized
+std::vector<limb_t> barrett_mu(const limb_t* m, size_t n);
+// r[0, n) = a b mod m, given mu[0, mun) from barrett_mu
+void barrett_mul(limb_t* r, const limb_t* a, const limb_t* b, const limb_t* m,
+                 size_t n, const limb_t* mu, size_t mun);
+
+// r = a b in some residue representation; `a` and `b` may be the same
+using ModMul = std::function<void(limb_t* r, const limb_t* a,
+                                  const limb_t* b)>;
+// r[0, n) = base^e by sliding windows, where `one` is the representation of
+//   1; `r` must not overlap the other arguments
+void pow_window(limb_t* r, const limb_t* base, const limb_t* one, size_t n,
+                const limb_t* e, size_t en, const ModMul& mul);
+
+// receives the digits of a conversion, most significant first, in pieces
+using DigitSink = std::function<void(const char* digits, size_t len)>;
+
+// the length (in limbs) below which decimal conversion stops splitting
+extern size_t radix_dc_threshold;
+
+// emits the decimal digits of a[0, n) without leading zeros (so nothing at
+//   all for zero)
+void to_decimal(const limb_t* a, size_t n, const DigitSink& sink);
+// parses `len` decimal digits; the caller has validated them
+std::vector<limb_t> from_decimal(const char* s, size_t len);
+
+// the same for radix 2^bits, with 1 <= bits <= 4
+void to_radix_pow2(const limb_t* a, size_t n, int bits, bool uppercase,
+                   const DigitSink& sink);
+std::vector<limb_t> from_radix_pow2(const char* s, size_t len, int bits);
+
+}  // namespace limbs
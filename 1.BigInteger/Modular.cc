@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "Limbs.hh"
+
+// Modular multiplication without division: Montgomery reduction for odd
+//   moduli, Barrett reduction for the rest, and a sliding-window
+//   exponentiation on top of either.
+namespace limbs
+{
+
+namespace
+{
+
+// per-thread room for the double-length products
+limb_t* scratch(size_t n)
+{
+    thread_local std::vector<limb_t> buffer;
+    if (buffer.size() < n)
+        buffer.resize(n);
+    return buffer.data();
+}
+
+// t[0, 2n) = a * b, squaring when the operands are the same
+void product(limb_t* t, const limb_t* a, const limb_t* b, size_t n)
+{
+    if (a == b)
+        sqr(t, a, n);
+    else
+        mul(t, a, n, b, n);
+}
+
+int exponent_bit(const limb_t* e, size_t bit)
+{
+    return (e[bit / LIMB_BITS] >> (bit % LIMB_BITS)) & 1;
+}
+
+// the window width that minimizes the multiplications for an exponent of
+//   this many bits, precomputation included
+int window_bits(size_t bits)
+{
+    if (bits > 671)
+        return 6;
+    if (bits > 239)
+        return 5;
+    if (bits > 79)
+        return 4;
+    if (bits > 23)
+        return 3;
+    return bits > 7 ? 2 : 1;
+}
+
+}  // namespace
+
+limb_t mont_n0inv(limb_t m0)
+{
+    assert(m0 & 1);
+    // m0 is its own inverse mod 8; each Newton step doubles the correct bits
+    limb_t inv = m0;
+    for (int i = 0; i < 4; ++i)
+        inv *= 2 - m0 * inv;
+    return -inv;
+}
+
+void mont_redc(limb_t* r, limb_t* t, const limb_t* m, size_t n, limb_t n0inv)
+{
+    // add multiples of m that clear t one limb at a time from the bottom,
+    //   keeping the carry out of the top limb aside
+    limb_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        limb_t c = addmul_1(t + i, m, n, t[i] * n0inv);
+        dlimb_t top = static_cast<dlimb_t>(t[i + n]) + c + carry;
+        t[i + n] = static_cast<limb_t>(top);
+        carry = static_cast<limb_t>(top >> LIMB_BITS);
+    }
+    // t / B^n < 2m now
+    if (carry || cmp_n(t + n, m, n) >= 0)
+        sub_n(r, t + n, m, n);
+    else
+        std::copy(t + n, t + 2 * n, r);
+}
+
+void mont_mul(limb_t* r, const limb_t* a, const limb_t* b, const limb_t* m,
+              size_t n, limb_t n0inv)
+{
+    limb_t* t = scratch(2 * n);
+    product(t, a, b, n);
+    mont_redc(r, t, m, n, n0inv);
+}
+
+std::vector<limb_t> barrett_mu(const limb_t* m, size_t n)
+{
+    std::vector<limb_t> power(2 * n + 1, 0), mu(n + 2);
+    power[2 * n] = 1;
+    divmod(mu.data(), nullptr, power.data(), power.size(), m, n);
+    mu.resize(normalized_size(mu.data(), mu.size()));
+    return mu;
+}
+
+void barrett_mul(limb_t* r, const limb_t* a, const limb_t* b, const limb_t* m,
+                 size_t n, const limb_t* mu, size_t mun)
+{
+    // for t = a b < m^2, the estimate q3 = floor(floor(t / B^(n-1)) mu /
+    //   B^(n+1)) is at most two below floor(t / m)
+    limb_t* t = scratch(2 * n + (n + 1 + mun) + (2 * n + 1) + (n + 1));
+    limb_t* q2 = t + 2 * n;
+    limb_t* p = q2 + n + 1 + mun;
+    limb_t* rem = p + 2 * n + 1;
+    product(t, a, b, n);
+    mul(q2, t + n - 1, n + 1, mu, mun);
+    // q3 < m < B^n, so n + 1 limbs hold it
+    mul(p, q2 + n + 1, n + 1, m, n);
+    sub_n(rem, t, p, n + 1);
+    while (rem[n] || cmp_n(rem, m, n) >= 0)
+        sub(rem, rem, n + 1, m, n);
+    std::copy(rem, rem + n, r);
+}
+
+void pow_window(limb_t* r, const limb_t* base, const limb_t* one, size_t n,
+                const limb_t* e, size_t en, const ModMul& mul)
+{
+    en = normalized_size(e, en);
+    if (en == 0) {
+        std::copy(one, one + n, r);
+        return;
+    }
+    size_t bits = en * LIMB_BITS - count_leading_zeros(e[en - 1]);
+    int w = window_bits(bits);
+
+    // the odd powers base^1, base^3, ..., base^(2^w - 1)
+    std::vector<limb_t> table(n << (w - 1)), square(n);
+    std::copy(base, base + n, table.begin());
+    if (w > 1) {
+        mul(square.data(), base, base);
+        for (size_t k = 1; k < (size_t(1) << (w - 1)); ++k)
+            mul(&table[k * n], &table[(k - 1) * n], square.data());
+    }
+
+    // scan from the top, taking windows that start and end with a one bit
+    bool started = false;
+    size_t i = bits;
+    while (i-- > 0) {
+        if (!exponent_bit(e, i)) {
+            mul(r, r, r);
+            continue;
+        }
+        size_t low = i + 1 >= static_cast<size_t>(w) ? i + 1 - w : 0;
+        while (!exponent_bit(e, low))
+            ++low;
+        size_t value = 0;
+        for (size_t j = i + 1; j-- > low; )
+            value = (value << 1) | exponent_bit(e, j);
+        const limb_t* odd_power = &table[(value >> 1) * n];
+        if (started) {
+            for (size_t j = low; j <= i; ++j)
+                mul(r, r, r);
+            mul(r, r, odd_power);
+        } else {
+            std::copy(odd_power, odd_power + n, r);
+            started = true;
+        }
+        i = low;
+    }
+}
+
+}  // namespace limbs
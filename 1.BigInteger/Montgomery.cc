@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "Montgomery.hh"
+
+// constructors
+MontgomeryContext::MontgomeryContext(const BigInteger& modulus)
+    : modulus_(modulus), n_(modulus.data_.size()), montgomery_(false)
+{
+    if (modulus_.sign_ <= 0)
+        throw std::runtime_error("modulus must be positive.");
+    const limbs::limb_t* m = modulus_.data_.data();
+    one_.assign(n_, 0);
+    one_[0] = 1;
+    if (m[0] & 1) {
+        montgomery_ = true;
+        n0inv_ = limbs::mont_n0inv(m[0]);
+        Limbs power(2 * n_ + 1, 0);
+        power[2 * n_] = 1;
+        r2_.resize(n_);
+        limbs::divmod(nullptr, r2_.data(), power.data(), power.size(), m, n_);
+        // 1 in Montgomery form is B^n mod m
+        mul_(one_.data(), one_.data(), r2_.data());
+    } else {
+        mu_ = limbs::barrett_mu(m, n_);
+    }
+}
+
+
+// accessors
+BigInteger MontgomeryContext::mulMod(const BigInteger& a,
+                                     const BigInteger& b) const
+{
+    Limbs x = reduce_(a), y = reduce_(b);
+    mul_(x.data(), x.data(), y.data());
+    // the Montgomery product left a factor of 1 / B^n behind
+    if (montgomery_)
+        mul_(x.data(), x.data(), r2_.data());
+    return toBigInteger_(x);
+}
+
+BigInteger MontgomeryContext::powMod(const BigInteger& base,
+                                     const BigInteger& exp) const
+{
+    if (exp.sign_ < 0)
+        throw std::runtime_error("exponent must be non-negative.");
+    Limbs x = reduce_(base), r(n_);
+    if (montgomery_)
+        mul_(x.data(), x.data(), r2_.data());
+    limbs::pow_window(r.data(), x.data(), one_.data(), n_,
+                      exp.data_.data(), exp.data_.size(),
+                      [this](limbs::limb_t* r, const limbs::limb_t* a,
+                             const limbs::limb_t* b) { mul_(r, a, b); });
+    if (montgomery_) {
+        Limbs unit(n_, 0);
+        unit[0] = 1;
+        mul_(r.data(), r.data(), unit.data());
+    }
+    return toBigInteger_(r);
+}
+
+
+// helper functions
+//   returns a mod m in n limbs, which only divides when a is out of range
+MontgomeryContext::Limbs MontgomeryContext::reduce_(const BigInteger& a) const
+{
+    Limbs r(n_, 0);
+    if (a.sign_ >= 0 && a.unsignedCompareTo(modulus_) < 0) {
+        std::copy(a.data_.begin(), a.data_.end(), r.begin());
+    } else {
+        BigInteger rem = a % modulus_;
+        if (rem.sign_ < 0)
+            rem += modulus_;
+        std::copy(rem.data_.begin(), rem.data_.end(), r.begin());
+    }
+    return r;
+}
+
+BigInteger MontgomeryContext::toBigInteger_(const Limbs& a) const
+{
+    BigInteger result;
+    result.data_.assign(a.data(), a.data() + a.size());
+    result.trim_();
+    result.sign_ = result.data_.empty() ? 0 : 1;
+    return result;
+}
+
+void MontgomeryContext::mul_(limbs::limb_t* r, const limbs::limb_t* a,
+                             const limbs::limb_t* b) const
+{
+    const limbs::limb_t* m = modulus_.data_.data();
+    if (montgomery_)
+        limbs::mont_mul(r, a, b, m, n_, n0inv_);
+    else
+        limbs::barrett_mul(r, a, b, m, n_, mu_.data(), mu_.size());
+}
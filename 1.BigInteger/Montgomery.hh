@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+
+#include "BigInteger.hh"
+
+// Arithmetic modulo a fixed positive modulus. The constructor does all the
+//   per-modulus work, so that mulMod and powMod need no division beyond
+//   reducing operands that are out of range. Odd moduli are handled in
+//   Montgomery form; even ones, which have none, fall back to Barrett
+//   reduction.
+class MontgomeryContext
+{
+  public:
+    // constructors
+    explicit MontgomeryContext(const BigInteger& modulus);
+
+    // accessors
+    const BigInteger& modulus() const { return modulus_; }
+    BigInteger mulMod(const BigInteger& a, const BigInteger& b) const;
+    //   exp must not be negative
+    BigInteger powMod(const BigInteger& base, const BigInteger& exp) const;
+
+  private:
+    using Limbs = std::vector<limbs::limb_t>;
+
+    BigInteger modulus_;
+    size_t n_;
+    bool montgomery_;
+    limbs::limb_t n0inv_ = 0;  // -1 / m mod B
+    Limbs r2_;                 // B^(2n) mod m, for moving into Montgomery form
+    Limbs one_;                // 1 as a working residue
+    Limbs mu_;                 // floor(B^(2n) / m), for Barrett reduction
+
+    // helper functions
+    Limbs reduce_(const BigInteger& a) const;
+    BigInteger toBigInteger_(const Limbs& a) const;
+    void mul_(limbs::limb_t* r, const limbs::limb_t* a,
+              const limbs::limb_t* b) const;
+};
@@ -0,0 +1,550 @@
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#include "Limbs.hh"
+#include "ThreadPool.hh"
+
+// The multiplication engine: schoolbook, Karatsuba, Toom-3 and a two-prime
+//   number-theoretic transform, picked by the size of the shorter operand.
+//   The independent subproducts of long operands run on the shared pool.
+namespace limbs
+{
+
+MulThresholds mul_thresholds;
+
+namespace
+{
+
+using Limbs = std::vector<limb_t>;
+
+// the pool to fork the subproducts of an n-limb split onto, if any
+ThreadPool* fork_pool(size_t n)
+{
+    return n >= parallel_grain ? shared_pool() : nullptr;
+}
+
+void zero(limb_t* r, size_t n)
+{
+    std::fill(r, r + n, 0);
+}
+
+// r[0, rn) += a[0, an), where rn >= an; the carry out is dropped, so the
+//   caller must know that the sum fits
+void accumulate(limb_t* r, size_t rn, const limb_t* a, size_t an)
+{
+    an = normalized_size(a, an);
+    assert(an <= rn);
+    limb_t carry = add_n(r, r, a, an);
+    add_1(r + an, r + an, rn - an, carry);
+}
+
+void sqr_basecase(limb_t* r, const limb_t* a, size_t n)
+{
+    // the off-diagonal products a[i] * a[j] for i < j, doubled, plus the
+    //   squares on the diagonal
+    zero(r, 2 * n);
+    for (size_t i = 0; i + 1 < n; ++i)
+        r[n + i] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    r[2 * n - 1] = add_n(r, r, r, 2 * n - 1);
+    dlimb_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        dlimb_t sq = static_cast<dlimb_t>(a[i]) * a[i];
+        carry += static_cast<dlimb_t>(r[2 * i]) + static_cast<limb_t>(sq);
+        r[2 * i] = static_cast<limb_t>(carry);
+        carry >>= LIMB_BITS;
+        carry += static_cast<dlimb_t>(r[2 * i + 1]) + (sq >> LIMB_BITS);
+        r[2 * i + 1] = static_cast<limb_t>(carry);
+        carry >>= LIMB_BITS;
+    }
+}
+
+
+// Karatsuba: with a = a1 x + a0 and b = b1 x + b0,
+//   a * b = a1 b1 x^2 + ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) x + a0 b0.
+//   Requires bn <= an < 2 bn.
+void mul_karatsuba(limb_t* r, const limb_t* a, size_t an,
+                   const limb_t* b, size_t bn)
+{
+    size_t h = an / 2;
+    const limb_t *a0 = a, *a1 = a + h, *b0 = b, *b1 = b + h;
+    size_t a1n = an - h, b1n = bn - h;
+
+    TaskGroup group(fork_pool(bn));
+    group.run([=] { mul(r, a0, h, b0, h); });
+    group.run([=] { mul(r + 2 * h, a1, a1n, b1, b1n); });
+
+    Limbs sa(a1n + 1), sb(std::max(h, b1n) + 1);
+    sa[a1n] = add(sa.data(), a1, a1n, a0, h);
+    if (b1n >= h)
+        sb[b1n] = add(sb.data(), b1, b1n, b0, h);
+    else
+        sb[h] = add(sb.data(), b0, h, b1, b1n);
+    // the operands may carry leading zeros, so the middle product keeps the
+    //   full width to leave room for subtracting both outer products
+    Limbs mid(sa.size() + sb.size());
+    mul(mid.data(), sa.data(), sa.size(), sb.data(), sb.size());
+    group.wait();
+    size_t midn = mid.size();
+    sub(mid.data(), mid.data(), midn, r, 2 * h);
+    sub(mid.data(), mid.data(), midn, r + 2 * h, a1n + b1n);
+    accumulate(r + h, an + bn - h, mid.data(), midn);
+}
+
+void sqr_karatsuba(limb_t* r, const limb_t* a, size_t n)
+{
+    size_t h = n / 2;
+    const limb_t *a0 = a, *a1 = a + h;
+    size_t a1n = n - h;
+
+    TaskGroup group(fork_pool(n));
+    group.run([=] { sqr(r, a0, h); });
+    group.run([=] { sqr(r + 2 * h, a1, a1n); });
+
+    Limbs sa(a1n + 1);
+    sa[a1n] = add(sa.data(), a1, a1n, a0, h);
+
+    Limbs mid(2 * sa.size());
+    sqr(mid.data(), sa.data(), sa.size());
+    group.wait();
+    size_t midn = mid.size();
+    sub(mid.data(), mid.data(), midn, r, 2 * h);
+    sub(mid.data(), mid.data(), midn, r + 2 * h, 2 * a1n);
+    accumulate(r + h, 2 * n - h, mid.data(), midn);
+}
+
+
+// a signed-magnitude number, for the negative intermediates of Toom-3
+struct Signed
+{
+    Limbs mag;
+    bool neg = false;
+
+    Signed() = default;
+    Signed(const limb_t* a, size_t n)
+        : mag(a, a + normalized_size(a, n))
+    {
+    }
+
+    void trim()
+    {
+        mag.resize(normalized_size(mag.data(), mag.size()));
+        if (mag.empty())
+            neg = false;
+    }
+};
+
+// returns |a| + |b|
+Limbs add_mag(const Limbs& a, const Limbs& b)
+{
+    const Limbs& l = a.size() < b.size() ? b : a;
+    const Limbs& s = a.size() < b.size() ? a : b;
+    Limbs r(l.size() + 1);
+    r[l.size()] = add(r.data(), l.data(), l.size(), s.data(), s.size());
+    return r;
+}
+
+// returns a + (negate_b ? -b : b)
+Signed add_signed(const Signed& a, const Signed& b, bool negate_b = false)
+{
+    bool bneg = b.neg != negate_b;
+    Signed r;
+    if (a.neg == bneg) {
+        r.mag = add_mag(a.mag, b.mag);
+        r.neg = a.neg;
+    } else {
+        int c = cmp(a.mag.data(), a.mag.size(), b.mag.data(), b.mag.size());
+        const Signed& l = c < 0 ? b : a;
+        const Signed& s = c < 0 ? a : b;
+        r.mag.resize(l.mag.size());
+        sub(r.mag.data(), l.mag.data(), l.mag.size(),
+            s.mag.data(), s.mag.size());
+        r.neg = c < 0 ? bneg : a.neg;
+    }
+    r.trim();
+    return r;
+}
+
+Signed mul_signed(const Signed& a, const Signed& b)
+{
+    Signed r;
+    if (a.mag.empty() || b.mag.empty())
+        return r;
+    r.mag.resize(a.mag.size() + b.mag.size());
+    if (&a == &b)
+        sqr(r.mag.data(), a.mag.data(), a.mag.size());
+    else
+        mul(r.mag.data(), a.mag.data(), a.mag.size(),
+            b.mag.data(), b.mag.size());
+    r.neg = a.neg != b.neg;
+    r.trim();
+    return r;
+}
+
+void mul_small(Signed& a, limb_t k)
+{
+    a.mag.push_back(mul_1(a.mag.data(), a.mag.data(), a.mag.size(), k));
+    a.trim();
+}
+
+// exact divisions by 2 and by 3
+void halve(Signed& a)
+{
+    limb_t carry = 0;
+    for (size_t i = a.mag.size(); i-- > 0; ) {
+        limb_t x = a.mag[i];
+        a.mag[i] = (x >> 1) | (carry << (LIMB_BITS - 1));
+        carry = x & 1;
+    }
+    assert(carry == 0);
+    a.trim();
+}
+
+void third(Signed& a)
+{
+    limb_t rem = divmod_1(a.mag.data(), a.mag.data(), a.mag.size(), 3);
+    assert(rem == 0);
+    (void)rem;
+    a.trim();
+}
+
+struct ToomPoints
+{
+    Signed p0, p1, pm1, pm2, pinf;
+};
+
+// evaluates m2 x^2 + m1 x + m0 at 0, 1, -1, -2 and infinity
+ToomPoints toom3_evaluate(const limb_t* m, size_t n, size_t k)
+{
+    Signed m0(m, k), m1(m + k, k), m2(m + 2 * k, n - 2 * k);
+    ToomPoints p;
+    Signed t = add_signed(m0, m2);
+    p.p0 = m0;
+    p.p1 = add_signed(t, m1);
+    p.pm1 = add_signed(t, m1, true);
+    p.pm2 = add_signed(p.pm1, m2);
+    mul_small(p.pm2, 2);
+    p.pm2 = add_signed(p.pm2, m0, true);
+    p.pinf = m2;
+    return p;
+}
+
+// Toom-3 following Bodrato's interpolation sequence. Requires that `b`
+//   splits into three non-empty parts of the size chosen for `a`.
+void mul_toom3(limb_t* r, const limb_t* a, size_t an,
+               const limb_t* b, size_t bn, bool square)
+{
+    size_t k = (an + 2) / 3;
+    assert(bn > 2 * k);
+
+    ToomPoints pa = toom3_evaluate(a, an, k);
+    ToomPoints pb;
+    if (!square)
+        pb = toom3_evaluate(b, bn, k);
+    auto pointwise = [square](const Signed& x, const Signed& y) {
+        return square ? mul_signed(x, x) : mul_signed(x, y);
+    };
+    Signed w0, w1, wm1, wm2, winf;
+    {
+        TaskGroup group(fork_pool(bn / 3));
+        group.run([&] { w0 = pointwise(pa.p0, pb.p0); });
+        group.run([&] { w1 = pointwise(pa.p1, pb.p1); });
+        group.run([&] { wm1 = pointwise(pa.pm1, pb.pm1); });
+        group.run([&] { wm2 = pointwise(pa.pm2, pb.pm2); });
+        winf = pointwise(pa.pinf, pb.pinf);
+        group.wait();
+    }
+
+    Signed r0 = w0, r4 = winf;
+    Signed r3 = add_signed(wm2, w1, true);
+    third(r3);
+    Signed r1 = add_signed(w1, wm1, true);
+    halve(r1);
+    Signed r2 = add_signed(wm1, w0, true);
+    r3 = add_signed(r2, r3, true);
+    halve(r3);
+    Signed twice_inf = winf;
+    mul_small(twice_inf, 2);
+    r3 = add_signed(r3, twice_inf);
+    r2 = add_signed(add_signed(r2, r1), r4, true);
+    r1 = add_signed(r1, r3, true);
+
+    // every coefficient of the product is non-negative
+    size_t rn = an + bn;
+    zero(r, rn);
+    const Signed* coeffs[] = { &r0, &r1, &r2, &r3, &r4 };
+    for (size_t i = 0; i < 5; ++i) {
+        assert(!coeffs[i]->neg);
+        if (i * k < rn)
+            accumulate(r + i * k, rn - i * k,
+                       coeffs[i]->mag.data(), coeffs[i]->mag.size());
+    }
+}
+
+
+// A number-theoretic transform over two NTT-friendly primes. Limbs are split
+//   into 16-bit pieces, so every convolution coefficient stays below
+//   2^24 * 2^32 < P1 * P2, and is recovered exactly by the CRT.
+const limb_t NTT_P1 = 167772161;  // 5 * 2^25 + 1
+const limb_t NTT_P2 = 469762049;  // 7 * 2^26 + 1
+const limb_t NTT_ROOT = 3;        // a primitive root of both primes
+const size_t NTT_MAX_LEN = size_t(1) << 25;
+
+// arithmetic modulo an odd prime p < 2^30 in Montgomery form, R = 2^32
+struct MontField
+{
+    limb_t p, pinv;  // pinv = -p^-1 mod 2^32
+    limb_t r2;       // R^2 mod p
+
+    explicit MontField(limb_t p_) : p(p_)
+    {
+        limb_t inv = p;
+        for (int i = 0; i < 4; ++i)
+            inv *= 2 - p * inv;
+        pinv = -inv;
+        dlimb_t r = (dlimb_t(1) << LIMB_BITS) % p;
+        r2 = static_cast<limb_t>(r * r % p);
+    }
+
+    limb_t reduce(dlimb_t t) const
+    {
+        limb_t m = static_cast<limb_t>(t) * pinv;
+        limb_t u = static_cast<limb_t>((t + static_cast<dlimb_t>(m) * p)
+                                       >> LIMB_BITS);
+        return u >= p ? u - p : u;
+    }
+    limb_t mul(limb_t a, limb_t b) const
+    {
+        return reduce(static_cast<dlimb_t>(a) * b);
+    }
+    limb_t to_mont(limb_t a) const { return mul(a, r2); }
+    limb_t add(limb_t a, limb_t b) const
+    {
+        limb_t s = a + b;
+        return s >= p ? s - p : s;
+    }
+    limb_t sub(limb_t a, limb_t b) const
+    {
+        return a >= b ? a - b : a + p - b;
+    }
+    // plain (non-Montgomery) exponentiation, for setting up the transform
+    limb_t pow(limb_t base, dlimb_t exp) const
+    {
+        dlimb_t res = 1, b = base % p;
+        for (; exp; exp >>= 1, b = b * b % p)
+            if (exp & 1)
+                res = res * b % p;
+        return static_cast<limb_t>(res);
+    }
+};
+
+// the twiddle factors in Montgomery form, laid out so that the butterflies
+//   of half-width `len` read roots[len, 2 len) = w_{2 len}^0, w_{2 len}^1, ...
+//   sequentially
+Limbs ntt_roots(const MontField& f, size_t n, bool inverse)
+{
+    Limbs roots(n);
+    for (size_t len = 1; len < n; len <<= 1) {
+        limb_t w = f.pow(NTT_ROOT, (f.p - 1) / (2 * len));
+        if (inverse)
+            w = f.pow(w, f.p - 2);
+        limb_t wm = f.to_mont(w);
+        roots[len] = f.to_mont(1);
+        for (size_t j = 1; j < len; ++j)
+            roots[len + j] = f.mul(roots[len + j - 1], wm);
+    }
+    return roots;
+}
+
+// decimation in frequency; leaves the output in bit-reversed order
+void ntt_forward(const MontField& f, limb_t* a, size_t n, const Limbs& roots)
+{
+    for (size_t len = n / 2; len >= 1; len >>= 1) {
+        const limb_t* w = roots.data() + len;
+        for (size_t i = 0; i < n; i += 2 * len) {
+            limb_t *x = a + i, *y = a + i + len;
+            for (size_t j = 0; j < len; ++j) {
+                limb_t u = x[j], v = y[j];
+                x[j] = f.add(u, v);
+                y[j] = f.mul(f.sub(u, v), w[j]);
+            }
+        }
+    }
+}
+
+// decimation in time; takes bit-reversed input, produces natural order
+void ntt_inverse(const MontField& f, limb_t* a, size_t n, const Limbs& roots)
+{
+    for (size_t len = 1; len < n; len <<= 1) {
+        const limb_t* w = roots.data() + len;
+        for (size_t i = 0; i < n; i += 2 * len) {
+            limb_t *x = a + i, *y = a + i + len;
+            for (size_t j = 0; j < len; ++j) {
+                limb_t u = x[j], v = f.mul(y[j], w[j]);
+                x[j] = f.add(u, v);
+                y[j] = f.sub(u, v);
+            }
+        }
+    }
+}
+
+void split_pieces(limb_t* out, const limb_t* a, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        out[2 * i] = a[i] & 0xffff;
+        out[2 * i + 1] = a[i] >> 16;
+    }
+}
+
+// the cyclic convolution of the pieces modulo one prime, in natural order
+Limbs ntt_convolve(const MontField& f, const Limbs& pa, const Limbs* pb,
+                   size_t len)
+{
+    TaskGroup group(shared_pool());
+    Limbs inverse_roots, fb;
+    group.run([&] { inverse_roots = ntt_roots(f, len, true); });
+    Limbs roots = ntt_roots(f, len, false);
+    if (pb) {
+        group.run([&] {
+            fb = *pb;
+            ntt_forward(f, fb.data(), len, roots);
+        });
+    }
+    Limbs fa(pa);
+    ntt_forward(f, fa.data(), len, roots);
+    group.wait();
+    if (pb) {
+        for (size_t i = 0; i < len; ++i)
+            fa[i] = f.mul(fa[i], fb[i]);
+    } else {
+        for (size_t i = 0; i < len; ++i)
+            fa[i] = f.mul(fa[i], fa[i]);
+    }
+    ntt_inverse(f, fa.data(), len, inverse_roots);
+    // the pointwise products picked up a factor R^-1; undo it together with
+    //   the 1/len scaling in one Montgomery multiplication
+    limb_t scale = f.pow(static_cast<limb_t>(len % f.p), f.p - 2);
+    scale = f.mul(f.to_mont(scale), f.r2);
+    for (size_t i = 0; i < len; ++i)
+        fa[i] = f.mul(fa[i], scale);
+    return fa;
+}
+
+void mul_ntt(limb_t* r, const limb_t* a, size_t an,
+             const limb_t* b, size_t bn, bool square)
+{
+    size_t pieces = 2 * (an + bn);
+    size_t len = 1;
+    while (len < pieces)
+        len <<= 1;
+    assert(len <= NTT_MAX_LEN);
+
+    Limbs pa(len, 0), pb;
+    split_pieces(pa.data(), a, an);
+    if (!square) {
+        pb.assign(len, 0);
+        split_pieces(pb.data(), b, bn);
+    }
+    const MontField f1(NTT_P1), f2(NTT_P2);
+    const Limbs* second = square ? nullptr : &pb;
+    Limbs c1, c2;
+    {
+        TaskGroup group(shared_pool());
+        group.run([&] { c1 = ntt_convolve(f1, pa, second, len); });
+        c2 = ntt_convolve(f2, pa, second, len);
+        group.wait();
+    }
+
+    // CRT: x = x1 + P1 * ((x2 - x1) * P1^-1 mod P2), then carry the 16-bit
+    //   pieces back into limbs
+    const dlimb_t p1_inv = f2.pow(NTT_P1 % NTT_P2, NTT_P2 - 2);
+    dlimb_t carry = 0;
+    for (size_t i = 0; i < pieces; ++i) {
+        dlimb_t x1 = c1[i], x2 = c2[i];
+        dlimb_t t = (x2 + NTT_P2 - x1 % NTT_P2) % NTT_P2 * p1_inv % NTT_P2;
+        carry += x1 + t * NTT_P1;
+        limb_t piece = static_cast<limb_t>(carry & 0xffff);
+        carry >>= 16;
+        if (i & 1)
+            r[i / 2] |= piece << 16;
+        else
+            r[i / 2] = piece;
+    }
+    assert(carry == 0);
+}
+
+// Karatsuba only shrinks the problem from four limbs up, whatever the
+//   tuning says
+size_t karatsuba_threshold()
+{
+    return std::max<size_t>(mul_thresholds.karatsuba, 4);
+}
+
+// whether `b` is long enough to be cut into three parts sized after `a`
+bool toom3_fits(size_t an, size_t bn)
+{
+    return bn > 2 * ((an + 2) / 3);
+}
+
+}  // namespace
+
+void mul(limb_t* r, const limb_t* a, size_t an, const limb_t* b, size_t bn)
+{
+    if (an < bn) {
+        std::swap(a, b);
+        std::swap(an, bn);
+    }
+    if (a == b && an == bn) {
+        sqr(r, a, an);
+        return;
+    }
+    const MulThresholds& t = mul_thresholds;
+    if (bn < karatsuba_threshold()) {
+        mul_basecase(r, a, an, b, bn);
+    } else if (bn >= t.ntt && 2 * (an + bn) <= NTT_MAX_LEN) {
+        mul_ntt(r, a, an, b, bn, false);
+    } else if (an >= 2 * bn) {
+        // unbalanced: multiply `b` by bn-limb slices of `a`, all at once
+        //   when they can run in parallel
+        zero(r, an + bn);
+        ThreadPool* pool = fork_pool(bn);
+        size_t slices = pool ? (an + bn - 1) / bn : 1;
+        Limbs parts(slices * 2 * bn);
+        for (size_t off = 0; off < an; off += slices * bn) {
+            TaskGroup group(pool);
+            for (size_t s = 0; s < slices && off + s * bn < an; ++s) {
+                group.run([=, &parts] {
+                    size_t start = off + s * bn;
+                    mul(&parts[s * 2 * bn], a + start,
+                        std::min(bn, an - start), b, bn);
+                });
+            }
+            group.wait();
+            for (size_t s = 0; s < slices && off + s * bn < an; ++s) {
+                size_t start = off + s * bn, len = std::min(bn, an - start);
+                accumulate(r + start, an + bn - start, &parts[s * 2 * bn],
+                           len + bn);
+            }
+        }
+    } else if (bn >= t.toom3 && toom3_fits(an, bn)) {
+        mul_toom3(r, a, an, b, bn, false);
+    } else {
+        mul_karatsuba(r, a, an, b, bn);
+    }
+}
+
+void sqr(limb_t* r, const limb_t* a, size_t n)
+{
+    const MulThresholds& t = mul_thresholds;
+    if (n < karatsuba_threshold())
+        sqr_basecase(r, a, n);
+    else if (n >= t.ntt && 4 * n <= NTT_MAX_LEN)
+        mul_ntt(r, a, n, a, n, true);
+    else if (n >= t.toom3)
+        mul_toom3(r, a, n, a, n, true);
+    else
+        sqr_karatsuba(r, a, n);
+}
+
+}  // namespace limbs
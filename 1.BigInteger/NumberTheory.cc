@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+#include "BigInteger.hh"
+
+// gcd, modular inverse and integer roots. Lehmer's gcd runs most of
+//   Euclid's algorithm on the leading 60 bits in machine words; the roots
+//   are Newton iterations started from the root of the leading half, so
+//   that a single step or two finishes each level.
+
+namespace
+{
+
+using limbs::limb_t;
+using limbs::dlimb_t;
+
+// floor(a / 2^shift) mod 2^64
+std::uint64_t bitsAt(const limb_t* a, size_t n, size_t shift)
+{
+    size_t i = shift / limbs::LIMB_BITS;
+    int offset = shift % limbs::LIMB_BITS;
+    auto limb = [a, n](size_t j) -> dlimb_t { return j < n ? a[j] : 0; };
+    std::uint64_t low = limb(i) | (limb(i + 1) << limbs::LIMB_BITS);
+    std::uint64_t value = low >> offset;
+    if (offset)
+        value |= limb(i + 2) << (2 * limbs::LIMB_BITS - offset);
+    return value;
+}
+
+std::uint64_t binaryGcd(std::uint64_t a, std::uint64_t b)
+{
+    if (a == 0 || b == 0)
+        return a | b;
+    int shift = __builtin_ctzll(a | b);
+    a >>= __builtin_ctzll(a);
+    do {
+        b >>= __builtin_ctzll(b);
+        if (a > b)
+            std::swap(a, b);
+        b -= a;
+    } while (b);
+    return a << shift;
+}
+
+std::uint64_t isqrt64(std::uint64_t n)
+{
+    if (n == 0)
+        return 0;
+    std::uint64_t x = std::min<std::uint64_t>(
+        static_cast<std::uint64_t>(std::sqrt(static_cast<double>(n))),
+        0xffffffffu);
+    // the double estimate is off by at most a unit or so either way
+    while (x > n / x)
+        --x;
+    while (x + 1 <= n / (x + 1))
+        ++x;
+    return x;
+}
+
+// (a, b) = (ca a + cb b, da a + db b), with `t` as scratch
+void combine(BigInteger& a, BigInteger& b, long long ca, long long cb,
+             long long da, long long db, BigInteger& t)
+{
+    BigInteger next_b = a * da;
+    t.assign(b);
+    t *= db;
+    next_b += t;
+    a *= ca;
+    b *= cb;
+    a += b;
+    b = std::move(next_b);
+}
+
+BigInteger power(BigInteger base, int exp)
+{
+    BigInteger result = 1;
+    for (; exp; exp >>= 1) {
+        if (exp & 1)
+            result *= base;
+        if (exp > 1)
+            base *= base;
+    }
+    return result;
+}
+
+}  // namespace
+
+
+// accessors
+BigInteger BigInteger::gcd(const BigInteger& rhs) const
+{
+    return lehmerGcd_(abs(), rhs.abs(), nullptr);
+}
+
+BigInteger BigInteger::extendedGcd(const BigInteger& rhs, BigInteger& x,
+                                   BigInteger& y) const
+{
+    BigInteger a = abs(), b = rhs.abs(), u;
+    BigInteger g = lehmerGcd_(a, b, &u);
+    // g = u |this| + v |rhs|
+    BigInteger v;
+    if (b.sign_ != 0)
+        v = (g - u * a) / b;
+    x = sign_ < 0 ? -u : u;
+    y = rhs.sign_ < 0 ? -v : v;
+    return g;
+}
+
+BigInteger BigInteger::modInverse(const BigInteger& mod) const
+{
+    if (mod.sign_ <= 0)
+        throw std::runtime_error("modulus must be positive.");
+    BigInteger reduced = *this % mod, x, y;
+    if (reduced.sign_ < 0)
+        reduced += mod;
+    if (!(reduced.extendedGcd(mod, x, y) == 1))
+        throw std::runtime_error("no modular inverse.");
+    x %= mod;
+    if (x.sign_ < 0)
+        x += mod;
+    return x;
+}
+
+BigInteger BigInteger::isqrt() const
+{
+    return iroot(2);
+}
+
+BigInteger BigInteger::iroot(int k) const
+{
+    if (k <= 0)
+        throw std::runtime_error("root index must be positive.");
+    if (sign_ < 0) {
+        if (k % 2 == 0)
+            throw std::runtime_error("even root of a negative number.");
+        return -abs().iroot(k);
+    }
+    if (sign_ == 0 || k == 1)
+        return *this;
+    size_t bits = bitLength_();
+    if (static_cast<size_t>(k) >= bits)
+        return 1;  // 1 <= this < 2^k
+    if (k == 2 && bits <= 64)
+        return BigInteger().assignUnsigned_(
+            isqrt64(bitsAt(data_.data(), data_.size(), 0)));
+
+    // an overestimate from the root of the leading half of the bits, which
+    //   is exact to about a quarter of them; for short roots, from 2^bits
+    size_t root_bits = (bits + k - 1) / k;
+    BigInteger x;
+    if (root_bits <= 32) {
+        x.assignUnsigned_(1);
+        x = x.shifted_(static_cast<long>(root_bits));
+    } else {
+        size_t half = root_bits / 2;
+        BigInteger top = shifted_(-static_cast<long>(half * k)).iroot(k);
+        top += 1;
+        x = top.shifted_(static_cast<long>(half));
+    }
+    // Newton's iteration decreases monotonically from above until it
+    //   reaches the floor of the root
+    for (;;) {
+        BigInteger y = x * (k - 1) + *this / power(x, k - 1);
+        y /= k;
+        if (!(y < x))
+            return x;
+        x = std::move(y);
+    }
+}
+
+
+// helper functions
+//   Lehmer's algorithm (Knuth 4.5.2, in the form of CPython's _PyLong_GCD)
+//   on non-negative a and b; `cofactor` receives u with u a == gcd mod b
+BigInteger BigInteger::lehmerGcd_(BigInteger a, BigInteger b,
+                                  BigInteger* cofactor)
+{
+    BigInteger ua = 1, ub = 0, t;
+    if (a < b) {
+        std::swap(a, b);
+        std::swap(ua, ub);
+    }
+    while (a.data_.size() > 2 && b.sign_ != 0) {
+        // the top 60 bits of a, and the bits of b in the same places
+        size_t shift = a.bitLength_() - 60;
+        std::uint64_t x = bitsAt(a.data_.data(), a.data_.size(), shift);
+        std::uint64_t y = bitsAt(b.data_.data(), b.data_.size(), shift);
+
+        // run Euclid on x and y while the quotients provably match those of
+        //   a and b; the cofactors stay below 2^30
+        std::uint64_t A = 1, B = 0, C = 0, D = 1;
+        int k = 0;
+        for (;; ++k) {
+            if (y - C == 0)
+                break;
+            std::uint64_t q = (x + (A - 1)) / (y - C);
+            std::uint64_t s = B + q * D;
+            std::uint64_t r = x - q * y;
+            if (s > r)
+                break;
+            x = y;
+            y = r;
+            r = A + q * C;
+            A = D;
+            B = C;
+            C = s;
+            D = r;
+        }
+
+        if (k == 0) {
+            // no progress: the quotient is too large, so divide in full
+            BigInteger q, r;
+            a.divmod(b, q, r);
+            a = std::move(b);
+            b = std::move(r);
+            if (cofactor) {
+                ua -= q * ub;
+                std::swap(ua, ub);
+            }
+            continue;
+        }
+        long long a0 = A, b0 = B, c0 = C, d0 = D;
+        if (k % 2 == 0) {
+            combine(a, b, a0, -b0, -c0, d0, t);
+            if (cofactor)
+                combine(ua, ub, a0, -b0, -c0, d0, t);
+        } else {
+            combine(a, b, -b0, a0, d0, -c0, t);
+            if (cofactor)
+                combine(ua, ub, -b0, a0, d0, -c0, t);
+        }
+    }
+
+    if (!cofactor) {
+        // both fit in 64 bits now
+        std::uint64_t x = bitsAt(a.data_.data(), a.data_.size(), 0);
+        std::uint64_t y = bitsAt(b.data_.data(), b.data_.size(), 0);
+        if (a.data_.size() <= 2)
+            return BigInteger().assignUnsigned_(binaryGcd(x, y));
+        return a;  // b is zero
+    }
+    while (b.sign_ != 0) {
+        BigInteger q, r;
+        a.divmod(b, q, r);
+        a = std::move(b);
+        b = std::move(r);
+        ua -= q * ub;
+        std::swap(ua, ub);
+    }
+    *cofactor = std::move(ua);
+    return a;
+}
+
+size_t BigInteger::bitLength_() const
+{
+    if (data_.empty())
+        return 0;
+    return data_.size() * limbs::LIMB_BITS
+           - limbs::count_leading_zeros(data_.back());
+}
+
+//   the magnitude times 2^bits, rounding towards zero for negative bits
+BigInteger BigInteger::shifted_(long bits) const
+{
+    BigInteger result;
+    if (sign_ == 0)
+        return result;
+    size_t n = data_.size();
+    if (bits >= 0) {
+        size_t limbs_off = bits / limbs::LIMB_BITS;
+        result.data_.resize(n + limbs_off + 1);
+        limb_t* r = result.data_.data();
+        r[n + limbs_off] = limbs::lshift(r + limbs_off, data_.data(), n,
+                                         bits % limbs::LIMB_BITS);
+    } else {
+        size_t limbs_off = static_cast<size_t>(-bits) / limbs::LIMB_BITS;
+        if (limbs_off >= n)
+            return result;
+        result.data_.resize(n - limbs_off);
+        limbs::rshift(result.data_.data(), data_.data() + limbs_off,
+                      n - limbs_off, static_cast<int>(-bits % limbs::LIMB_BITS));
+    }
+    result.trim_();
+    result.sign_ = result.data_.empty() ? 0 : 1;
+    return result;
+}
+
+BigInteger& BigInteger::assignUnsigned_(std::uint64_t num)
+{
+    data_.clear();
+    for (; num; num >>= limbs::LIMB_BITS)
+        data_.push_back(static_cast<limb_t>(num));
+    sign_ = data_.empty() ? 0 : 1;
+    return *this;
+}
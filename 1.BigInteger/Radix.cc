@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "Limbs.hh"
+
+// Radix conversion. Decimal goes through a divide-and-conquer split on a
+//   cached tree of powers 10^(9 * 2^k), so both directions cost a log factor
+//   over multiplication; power-of-two radixes are a linear bit repacking.
+namespace limbs
+{
+
+size_t radix_dc_threshold = 30;
+
+namespace
+{
+
+using Limbs = std::vector<limb_t>;
+
+// a level of the power tree; the divisor is only prepared once output
+//   needs it, as parsing only multiplies
+struct DecimalPower
+{
+    Limbs power;
+    PreparedDivisor divisor;
+    bool prepared = false;
+};
+
+std::deque<DecimalPower> powers;
+std::mutex powers_lock;
+
+// returns level k of the tree, 10^(9 * 2^k); levels are built by squaring
+//   and never change once complete, so references to them stay valid
+const DecimalPower& decimal_level(size_t k, bool need_divisor)
+{
+    std::lock_guard<std::mutex> guard(powers_lock);
+    if (powers.empty()) {
+        powers.emplace_back();
+        powers.back().power = Limbs{ DECIMAL_BASE };
+    }
+    while (powers.size() <= k) {
+        const Limbs& last = powers.back().power;
+        Limbs next(2 * last.size());
+        sqr(next.data(), last.data(), last.size());
+        next.resize(normalized_size(next.data(), next.size()));
+        powers.emplace_back();
+        powers.back().power = std::move(next);
+    }
+    DecimalPower& level = powers[k];
+    if (need_divisor && !level.prepared) {
+        level.divisor = prepare_divisor(level.power.data(), level.power.size());
+        level.prepared = true;
+    }
+    return level;
+}
+
+const Limbs& decimal_power(size_t k)
+{
+    return decimal_level(k, false).power;
+}
+
+size_t decimal_power_digits(size_t k)
+{
+    return static_cast<size_t>(DECIMAL_DIGITS) << k;
+}
+
+// emits the digits of a[0, n), zero-padded to `pad` digits when `pad` is
+//   non-zero, by peeling off base 10^9 chunks
+void to_decimal_basecase(const limb_t* a, size_t n, size_t pad,
+                         const DigitSink& sink)
+{
+    Limbs rest(a, a + n);
+    std::vector<char> digits(std::max(pad, (n + 1) * 10));
+    size_t pos = digits.size();
+    while (n) {
+        limb_t chunk = divmod_1(rest.data(), rest.data(), n, DECIMAL_BASE);
+        n = normalized_size(rest.data(), n);
+        for (int i = 0; i < DECIMAL_DIGITS && (n || chunk); ++i) {
+            digits[--pos] = '0' + chunk % 10;
+            chunk /= 10;
+        }
+    }
+    size_t written = digits.size() - pos;
+    if (pad > written) {
+        std::fill(digits.end() - pad, digits.begin() + pos, '0');
+        pos = digits.size() - pad;
+    }
+    sink(digits.data() + pos, digits.size() - pos);
+}
+
+void to_decimal_rec(const limb_t* a, size_t n, size_t pad,
+                    const DigitSink& sink)
+{
+    n = normalized_size(a, n);
+    if (n < std::max<size_t>(radix_dc_threshold, 2)) {
+        to_decimal_basecase(a, n, pad, sink);
+        return;
+    }
+    // split around the largest cached power of at most half the length
+    size_t k = 0;
+    while (2 * decimal_power(k + 1).size() <= n + 1)
+        ++k;
+    const DecimalPower& level = decimal_level(k, true);
+    size_t pn = level.power.size();
+    Limbs q(n - pn + 1), r(pn);
+    divmod(q.data(), r.data(), a, n, level.divisor);
+
+    size_t low_digits = decimal_power_digits(k);
+    to_decimal_rec(q.data(), q.size(), pad > low_digits ? pad - low_digits : 0,
+                   sink);
+    to_decimal_rec(r.data(), r.size(), low_digits, sink);
+}
+
+// parses s[0, len) into r[0, rn), where `r` is zeroed and long enough;
+//   the digits have already been validated
+void from_decimal_basecase(limb_t* r, size_t rn, const char* s, size_t len)
+{
+    size_t n = 0;
+    size_t chunk_len = len % DECIMAL_DIGITS;
+    if (chunk_len == 0)
+        chunk_len = DECIMAL_DIGITS;
+    for (size_t pos = 0; pos < len; pos += chunk_len,
+                                    chunk_len = DECIMAL_DIGITS) {
+        limb_t chunk = 0, scale = 1;
+        for (size_t j = pos; j < pos + chunk_len; ++j) {
+            chunk = chunk * 10 + (s[j] - '0');
+            scale *= 10;
+        }
+        limb_t carry = mul_1(r, r, n, scale);
+        if (carry)
+            r[n++] = carry;
+        carry = add_1(r, r, n, chunk);
+        if (carry)
+            r[n++] = carry;
+        assert(n <= rn);
+    }
+    (void)rn;
+}
+
+// an upper bound on the limbs taken by a `len`-digit decimal number
+size_t decimal_limbs(size_t len)
+{
+    // log2(10) < 3.33
+    return len * 333 / 100 / LIMB_BITS + 2;
+}
+
+Limbs from_decimal_rec(const char* s, size_t len)
+{
+    if (len <= std::max<size_t>(radix_dc_threshold, 2) * DECIMAL_DIGITS) {
+        Limbs r(decimal_limbs(len), 0);
+        from_decimal_basecase(r.data(), r.size(), s, len);
+        r.resize(normalized_size(r.data(), r.size()));
+        return r;
+    }
+    // the low part takes the largest power-of-the-tree digit count that
+    //   still leaves some digits for the high part
+    size_t k = 0;
+    while (decimal_power_digits(k + 1) < len)
+        ++k;
+    size_t low_digits = decimal_power_digits(k);
+    Limbs high = from_decimal_rec(s, len - low_digits);
+    Limbs low = from_decimal_rec(s + len - low_digits, low_digits);
+    const Limbs& power = decimal_power(k);
+    // low < power, so the sum carries at most into the extra limb
+    Limbs r(high.size() + power.size() + 1, 0);
+    if (!high.empty())
+        mul(r.data(), high.data(), high.size(), power.data(), power.size());
+    add(r.data(), r.data(), r.size(), low.data(), low.size());
+    r.resize(normalized_size(r.data(), r.size()));
+    return r;
+}
+
+}  // namespace
+
+void to_decimal(const limb_t* a, size_t n, const DigitSink& sink)
+{
+    to_decimal_rec(a, n, 0, sink);
+}
+
+std::vector<limb_t> from_decimal(const char* s, size_t len)
+{
+    return from_decimal_rec(s, len);
+}
+
+void to_radix_pow2(const limb_t* a, size_t n, int bits, bool uppercase,
+                   const DigitSink& sink)
+{
+    static const char lower[] = "0123456789abcdef";
+    static const char upper[] = "0123456789ABCDEF";
+    const char* alphabet = uppercase ? upper : lower;
+    n = normalized_size(a, n);
+    if (n == 0)
+        return;
+    size_t total_bits = n * LIMB_BITS - count_leading_zeros(a[n - 1]);
+    size_t ndigits = (total_bits + bits - 1) / bits;
+    const limb_t mask = (limb_t(1) << bits) - 1;
+
+    // emit from the most significant digit, through a bounded buffer
+    char buffer[4096];
+    size_t used = 0;
+    for (size_t d = ndigits; d-- > 0; ) {
+        size_t bit = d * bits;
+        size_t limb = bit / LIMB_BITS;
+        int offset = bit % LIMB_BITS;
+        limb_t value = a[limb] >> offset;
+        if (offset + bits > LIMB_BITS && limb + 1 < n)
+            value |= a[limb + 1] << (LIMB_BITS - offset);
+        buffer[used++] = alphabet[value & mask];
+        if (used == sizeof(buffer)) {
+            sink(buffer, used);
+            used = 0;
+        }
+    }
+    if (used)
+        sink(buffer, used);
+}
+
+std::vector<limb_t> from_radix_pow2(const char* s, size_t len, int bits)
+{
+    Limbs r((len * bits + LIMB_BITS - 1) / LIMB_BITS, 0);
+    size_t bit = 0;
+    for (size_t i = len; i-- > 0; bit += bits) {
+        char c = s[i];
+        limb_t value = c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+        size_t limb = bit / LIMB_BITS;
+        int offset = bit % LIMB_BITS;
+        r[limb] |= value << offset;
+        if (offset + bits > LIMB_BITS)
+            r[limb + 1] |= value >> (LIMB_BITS - offset);
+    }
+    r.resize(normalized_size(r.data(), r.size()));
+    return r;
+}
+
+}  // namespace limbs
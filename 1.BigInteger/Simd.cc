@@ -0,0 +1,348 @@
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LIMBS_X86 1
+#endif
+
+#include "Limbs.hh"
+
+// The linear add, subtract and compare kernels, in a scalar version and SIMD
+//   versions of increasing width; the widest one the CPU supports is picked
+//   on first use.
+//
+// Adding lane-wise leaves each lane to fix up with the carry out of the
+//   lanes below it. That carry ripples only through lanes that came out all
+//   ones, so with g marking the lanes that wrapped and p the all-ones lanes,
+//   the carries into every lane are
+//     ((g << 1 | carry_in) + p) ^ p,
+//   one integer addition per block, with the block's carry out in the bit
+//   above the lanes. Subtraction is the same with borrows, where the lanes
+//   that came out zero propagate.
+namespace limbs
+{
+
+namespace
+{
+
+limb_t add_n_scalar(limb_t* r, const limb_t* a, const limb_t* b, size_t n,
+                    limb_t carry_in)
+{
+    dlimb_t carry = carry_in;
+    for (size_t i = 0; i < n; ++i) {
+        carry += static_cast<dlimb_t>(a[i]) + b[i];
+        r[i] = static_cast<limb_t>(carry);
+        carry >>= LIMB_BITS;
+    }
+    return static_cast<limb_t>(carry);
+}
+
+limb_t sub_n_scalar(limb_t* r, const limb_t* a, const limb_t* b, size_t n,
+                    limb_t borrow)
+{
+    for (size_t i = 0; i < n; ++i) {
+        dlimb_t d = static_cast<dlimb_t>(a[i]) - b[i] - borrow;
+        r[i] = static_cast<limb_t>(d);
+        borrow = static_cast<limb_t>(d >> LIMB_BITS) & 1;
+    }
+    return borrow;
+}
+
+int cmp_n_scalar(const limb_t* a, const limb_t* b, size_t n)
+{
+    while (n-- > 0) {
+        if (a[n] != b[n])
+            return a[n] < b[n] ? -1 : 1;
+    }
+    return 0;  // equal
+}
+
+limb_t add_n_0(limb_t* r, const limb_t* a, const limb_t* b, size_t n)
+{
+    return add_n_scalar(r, a, b, n, 0);
+}
+
+limb_t sub_n_0(limb_t* r, const limb_t* a, const limb_t* b, size_t n)
+{
+    return sub_n_scalar(r, a, b, n, 0);
+}
+
+// returns the carries into the lanes of a block and updates `carry` to the
+//   carry out of it
+inline unsigned lookahead(unsigned g, unsigned p, unsigned& carry, int lanes)
+{
+    unsigned t = ((g << 1) | carry) + p;
+    carry = t >> lanes;
+    return (t ^ p) & ((1u << lanes) - 1);
+}
+
+// the index of the most significant set bit of a non-zero mask
+inline int top_lane(unsigned mask)
+{
+    return 31 - __builtin_clz(mask);
+}
+
+#ifdef LIMBS_X86
+
+__attribute__((target("sse4.2")))
+limb_t add_n_sse42(limb_t* r, const limb_t* a, const limb_t* b, size_t n)
+{
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+    unsigned carry = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        __m128i s = _mm_add_epi32(x, y);
+        // a lane wrapped iff its sum is below an addend
+        __m128i kept = _mm_cmpeq_epi32(_mm_max_epu32(s, x), s);
+        unsigned g = ~_mm_movemask_ps(_mm_castsi128_ps(kept)) & 0xf;
+        unsigned p = _mm_movemask_ps(
+            _mm_castsi128_ps(_mm_cmpeq_epi32(s, ones)));
+        unsigned c = lookahead(g, p, carry, 4);
+        // carries as lanes of all ones, which subtracting adds as one
+        __m128i cs = _mm_and_si128(_mm_set1_epi32(c), lane_bits);
+        s = _mm_sub_epi32(s, _mm_cmpeq_epi32(cs, lane_bits));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(r + i), s);
+    }
+    return add_n_scalar(r + i, a + i, b + i, n - i, carry);
+}
+
+__attribute__((target("sse4.2")))
+limb_t sub_n_sse42(limb_t* r, const limb_t* a, const limb_t* b, size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+    unsigned borrow = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        __m128i d = _mm_sub_epi32(x, y);
+        // a lane borrowed iff its subtrahend is above the minuend
+        __m128i kept = _mm_cmpeq_epi32(_mm_max_epu32(x, y), x);
+        unsigned g = ~_mm_movemask_ps(_mm_castsi128_ps(kept)) & 0xf;
+        unsigned p = _mm_movemask_ps(
+            _mm_castsi128_ps(_mm_cmpeq_epi32(d, zero)));
+        unsigned c = lookahead(g, p, borrow, 4);
+        __m128i cs = _mm_and_si128(_mm_set1_epi32(c), lane_bits);
+        d = _mm_add_epi32(d, _mm_cmpeq_epi32(cs, lane_bits));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(r + i), d);
+    }
+    return sub_n_scalar(r + i, a + i, b + i, n - i, borrow);
+}
+
+__attribute__((target("sse4.2")))
+int cmp_n_sse42(const limb_t* a, const limb_t* b, size_t n)
+{
+    while (n >= 4) {
+        n -= 4;
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + n));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + n));
+        unsigned diff = ~_mm_movemask_ps(
+            _mm_castsi128_ps(_mm_cmpeq_epi32(x, y))) & 0xf;
+        if (diff) {
+            size_t i = n + top_lane(diff);
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return cmp_n_scalar(a, b, n);
+}
+
+__attribute__((target("avx2")))
+limb_t add_n_avx2(limb_t* r, const limb_t* a, const limb_t* b, size_t n)
+{
+    const __m256i ones = _mm256_set1_epi32(-1);
+    const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    unsigned carry = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        __m256i s = _mm256_add_epi32(x, y);
+        __m256i kept = _mm256_cmpeq_epi32(_mm256_max_epu32(s, x), s);
+        unsigned g = ~_mm256_movemask_ps(_mm256_castsi256_ps(kept)) & 0xff;
+        unsigned p = _mm256_movemask_ps(
+            _mm256_castsi256_ps(_mm256_cmpeq_epi32(s, ones)));
+        unsigned c = lookahead(g, p, carry, 8);
+        __m256i cs = _mm256_and_si256(_mm256_set1_epi32(c), lane_bits);
+        s = _mm256_sub_epi32(s, _mm256_cmpeq_epi32(cs, lane_bits));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), s);
+    }
+    return add_n_scalar(r + i, a + i, b + i, n - i, carry);
+}
+
+__attribute__((target("avx2")))
+limb_t sub_n_avx2(limb_t* r, const limb_t* a, const limb_t* b, size_t n)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    unsigned borrow = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        __m256i d = _mm256_sub_epi32(x, y);
+        __m256i kept = _mm256_cmpeq_epi32(_mm256_max_epu32(x, y), x);
+        unsigned g = ~_mm256_movemask_ps(_mm256_castsi256_ps(kept)) & 0xff;
+        unsigned p = _mm256_movemask_ps(
+            _mm256_castsi256_ps(_mm256_cmpeq_epi32(d, zero)));
+        unsigned c = lookahead(g, p, borrow, 8);
+        __m256i cs = _mm256_and_si256(_mm256_set1_epi32(c), lane_bits);
+        d = _mm256_add_epi32(d, _mm256_cmpeq_epi32(cs, lane_bits));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), d);
+    }
+    return sub_n_scalar(r + i, a + i, b + i, n - i, borrow);
+}
+
+__attribute__((target("avx2")))
+int cmp_n_avx2(const limb_t* a, const limb_t* b, size_t n)
+{
+    while (n >= 8) {
+        n -= 8;
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + n));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + n));
+        unsigned diff = ~_mm256_movemask_ps(
+            _mm256_castsi256_ps(_mm256_cmpeq_epi32(x, y))) & 0xff;
+        if (diff) {
+            size_t i = n + top_lane(diff);
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return cmp_n_scalar(a, b, n);
+}
+
+// AVX-512 has the lane masks as registers, so no expanding is needed
+__attribute__((target("avx512f")))
+limb_t add_n_avx512(limb_t* r, const limb_t* a, const limb_t* b, size_t n)
+{
+    const __m512i ones = _mm512_set1_epi32(-1);
+    unsigned carry = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_loadu_si512(a + i);
+        __m512i y = _mm512_loadu_si512(b + i);
+        __m512i s = _mm512_add_epi32(x, y);
+        unsigned g = _mm512_cmplt_epu32_mask(s, x);
+        unsigned p = _mm512_cmpeq_epi32_mask(s, ones);
+        __mmask16 c = lookahead(g, p, carry, 16);
+        s = _mm512_mask_sub_epi32(s, c, s, ones);
+        _mm512_storeu_si512(r + i, s);
+    }
+    return add_n_scalar(r + i, a + i, b + i, n - i, carry);
+}
+
+__attribute__((target("avx512f")))
+limb_t sub_n_avx512(limb_t* r, const limb_t* a, const limb_t* b, size_t n)
+{
+    const __m512i ones = _mm512_set1_epi32(-1);
+    unsigned borrow = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i x = _mm512_loadu_si512(a + i);
+        __m512i y = _mm512_loadu_si512(b + i);
+        __m512i d = _mm512_sub_epi32(x, y);
+        unsigned g = _mm512_cmplt_epu32_mask(x, y);
+        unsigned p = _mm512_cmpeq_epi32_mask(d, _mm512_setzero_si512());
+        __mmask16 c = lookahead(g, p, borrow, 16);
+        d = _mm512_mask_add_epi32(d, c, d, ones);
+        _mm512_storeu_si512(r + i, d);
+    }
+    return sub_n_scalar(r + i, a + i, b + i, n - i, borrow);
+}
+
+__attribute__((target("avx512f")))
+int cmp_n_avx512(const limb_t* a, const limb_t* b, size_t n)
+{
+    while (n >= 16) {
+        n -= 16;
+        __m512i x = _mm512_loadu_si512(a + n);
+        __m512i y = _mm512_loadu_si512(b + n);
+        unsigned diff = _mm512_cmpneq_epi32_mask(x, y);
+        if (diff) {
+            size_t i = n + top_lane(diff);
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return cmp_n_scalar(a, b, n);
+}
+
+#endif  // LIMBS_X86
+
+struct Kernels
+{
+    limb_t (*add_n)(limb_t*, const limb_t*, const limb_t*, size_t);
+    limb_t (*sub_n)(limb_t*, const limb_t*, const limb_t*, size_t);
+    int (*cmp_n)(const limb_t*, const limb_t*, size_t);
+};
+
+// indexed by SimdLevel
+const Kernels kernel_table[] = {
+    { add_n_0, sub_n_0, cmp_n_scalar },
+#ifdef LIMBS_X86
+    { add_n_sse42, sub_n_sse42, cmp_n_sse42 },
+    { add_n_avx2, sub_n_avx2, cmp_n_avx2 },
+    { add_n_avx512, sub_n_avx512, cmp_n_avx512 },
+#endif
+};
+
+// -1 until the first kernel call picks a level
+std::atomic<int> selected_level(-1);
+
+SimdLevel best_simd_level()
+{
+#ifdef LIMBS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return SimdLevel::avx512;
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::avx2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return SimdLevel::sse42;
+#endif
+    return SimdLevel::scalar;
+}
+
+const Kernels& kernels()
+{
+    int level = selected_level.load(std::memory_order_relaxed);
+    if (level < 0) {
+        level = static_cast<int>(best_simd_level());
+        selected_level.store(level, std::memory_order_relaxed);
+    }
+    return kernel_table[level];
+}
+
+}  // namespace
+
+SimdLevel simd_level()
+{
+    kernels();
+    return static_cast<SimdLevel>(selected_level.load());
+}
+
+bool set_simd_level(SimdLevel level)
+{
+    if (level > best_simd_level())
+        return false;
+    selected_level.store(static_cast<int>(level));
+    return true;
+}
+
+int cmp_n(const limb_t* a, const limb_t* b, size_t n)
+{
+    return kernels().cmp_n(a, b, n);
+}
+
+limb_t add_n(limb_t* r, const limb_t* a, const limb_t* b, size_t n)
+{
+    return kernels().add_n(r, a, b, n);
+}
+
+limb_t sub_n(limb_t* r, const limb_t* a, const limb_t* b, size_t n)
+{
+    return kernels().sub_n(r, a, b, n);
+}
+
+}  // namespace limbs
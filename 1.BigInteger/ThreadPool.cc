@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <memory>
+
+#include "Limbs.hh"
+#include "ThreadPool.hh"
+
+// constructors
+ThreadPool::ThreadPool(size_t workers)
+{
+    for (size_t i = 0; i < workers; ++i)
+        threads_.emplace_back([this] { work_(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stopping_ = true;
+    }
+    ready_.notify_all();
+    for (auto& thread : threads_)
+        thread.join();
+}
+
+
+// modifiers
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        tasks_.push_back(std::move(task));
+    }
+    ready_.notify_one();
+}
+
+bool ThreadPool::runPending()
+{
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (tasks_.empty())
+            return false;
+        task = std::move(tasks_.back());
+        tasks_.pop_back();
+    }
+    task();
+    return true;
+}
+
+
+// helper functions
+void ThreadPool::work_()
+{
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> guard(lock_);
+            ready_.wait(guard, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+                return;
+            // the oldest task is the biggest piece of a recursive split
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+
+// constructors
+TaskGroup::TaskGroup(ThreadPool* pool)
+    : pool_(pool)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    // tasks refer to the group, so they must be done before it goes away
+    try {
+        wait();
+    } catch (...) {
+    }
+}
+
+
+// modifiers
+void TaskGroup::run(std::function<void()> task)
+{
+    if (!pool_) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        ++pending_;
+    }
+    pool_->submit([this, task] {
+        std::exception_ptr error;
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        finish_(error);
+    });
+}
+
+void TaskGroup::wait()
+{
+    std::unique_lock<std::mutex> guard(lock_);
+    while (pending_ > 0) {
+        // help with whatever is queued, which is often one of our own tasks
+        guard.unlock();
+        bool ran = pool_->runPending();
+        guard.lock();
+        if (!ran)
+            done_.wait(guard, [this] { return pending_ == 0; });
+    }
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+
+// helper functions
+void TaskGroup::finish_(std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    if (error && !error_)
+        error_ = error;
+    if (--pending_ == 0)
+        done_.notify_all();
+}
+
+
+namespace limbs
+{
+
+size_t parallel_grain = 1024;
+
+namespace
+{
+
+std::mutex pool_lock;
+std::unique_ptr<ThreadPool> pool;
+size_t thread_total = 0;  // 0 until configured
+
+void configure(size_t threads)
+{
+    thread_total = std::max<size_t>(threads, 1);
+    pool.reset();
+    if (thread_total > 1)
+        pool.reset(new ThreadPool(thread_total - 1));
+}
+
+}  // namespace
+
+void set_threads(size_t threads)
+{
+    std::lock_guard<std::mutex> guard(pool_lock);
+    configure(threads);
+}
+
+size_t threads()
+{
+    std::lock_guard<std::mutex> guard(pool_lock);
+    if (thread_total == 0)
+        configure(std::thread::hardware_concurrency());
+    return thread_total;
+}
+
+ThreadPool* shared_pool()
+{
+    std::lock_guard<std::mutex> guard(pool_lock);
+    if (thread_total == 0)
+        configure(std::thread::hardware_concurrency());
+    return pool.get();
+}
+
+}  // namespace limbs
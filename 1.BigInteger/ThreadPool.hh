@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads taking tasks from a shared queue, for the
+//   fork-join parallelism of the multiplication kernels. Tasks are forked
+//   through a TaskGroup, whose wait() runs queued tasks on the waiting
+//   thread, so nested forks never leave every thread blocked.
+class ThreadPool
+{
+  public:
+    // constructors
+    explicit ThreadPool(size_t workers);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    // accessors
+    size_t workers() const { return threads_.size(); }
+
+    // modifiers
+    void submit(std::function<void()> task);
+    //   runs one queued task on the calling thread; false if there was none
+    bool runPending();
+
+  private:
+    std::vector<std::thread> threads_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex lock_;
+    std::condition_variable ready_;
+    bool stopping_ = false;
+
+    // helper functions
+    void work_();
+};
+
+// Tasks forked together and joined with wait(). Without a pool, run()
+//   executes the task at once. The first exception thrown by a task is
+//   rethrown from wait().
+class TaskGroup
+{
+  public:
+    // constructors
+    explicit TaskGroup(ThreadPool* pool);
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    ~TaskGroup();
+
+    // modifiers
+    void run(std::function<void()> task);
+    void wait();
+
+  private:
+    ThreadPool* pool_;
+    size_t pending_ = 0;
+    std::mutex lock_;
+    std::condition_variable done_;
+    std::exception_ptr error_;
+
+    // helper functions
+    void finish_(std::exception_ptr error);
+};
+
+namespace limbs
+{
+
+// the pool the kernels fork onto, or null when limited to one thread
+ThreadPool* shared_pool();
+
+}  // namespace limbs
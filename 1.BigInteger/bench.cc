@@ -0,0 +1,105 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <benchmark/benchmark.h>
+
+#include "BigInteger.hh"
+
+// Throughput of the BigInteger operations against operand size, given in
+//   decimal digits from 1 to 10^6. `make bench` writes the results to
+//   bench.json as well as to the console.
+
+static std::string randomDigits(int64_t digits, unsigned seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> digit(0, 9);
+    std::string str(static_cast<size_t>(digits), '0');
+    str[0] = '1' + digit(generator) % 9;
+    for (size_t i = 1; i < str.size(); ++i)
+        str[i] = '0' + digit(generator);
+    return str;
+}
+
+static BigInteger randomOperand(int64_t digits, unsigned seed)
+{
+    return BigInteger(randomDigits(digits, seed));
+}
+
+static void sizes(benchmark::internal::Benchmark* bench)
+{
+    bench->RangeMultiplier(10)->Range(1, 1000000)
+        ->Unit(benchmark::kMicrosecond);
+}
+
+static void BM_Add(benchmark::State& state)
+{
+    BigInteger a = randomOperand(state.range(0), 1);
+    BigInteger b = randomOperand(state.range(0), 2);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a + b);
+}
+BENCHMARK(BM_Add)->Apply(sizes);
+
+static void BM_Sub(benchmark::State& state)
+{
+    BigInteger a = randomOperand(state.range(0), 1);
+    BigInteger b = randomOperand(state.range(0), 2);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a - b);
+}
+BENCHMARK(BM_Sub)->Apply(sizes);
+
+static void BM_Mul(benchmark::State& state)
+{
+    BigInteger a = randomOperand(state.range(0), 1);
+    BigInteger b = randomOperand(state.range(0), 2);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a * b);
+}
+BENCHMARK(BM_Mul)->Apply(sizes);
+
+static void BM_Square(benchmark::State& state)
+{
+    BigInteger a = randomOperand(state.range(0), 1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a * a);
+}
+BENCHMARK(BM_Square)->Apply(sizes);
+
+// a dividend of the given size over a divisor of half of it
+static void BM_Div(benchmark::State& state)
+{
+    BigInteger a = randomOperand(state.range(0), 1);
+    BigInteger b = randomOperand((state.range(0) + 1) / 2, 2);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a / b);
+}
+BENCHMARK(BM_Div)->Apply(sizes);
+
+// equal operands, so that every limb is compared
+static void BM_Compare(benchmark::State& state)
+{
+    BigInteger a = randomOperand(state.range(0), 1);
+    BigInteger b = a;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a.compareTo(b));
+}
+BENCHMARK(BM_Compare)->Apply(sizes);
+
+static void BM_ToString(benchmark::State& state)
+{
+    BigInteger a = randomOperand(state.range(0), 1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a.toString());
+}
+BENCHMARK(BM_ToString)->Apply(sizes);
+
+static void BM_FromString(benchmark::State& state)
+{
+    std::string str = randomDigits(state.range(0), 1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(BigInteger(str));
+}
+BENCHMARK(BM_FromString)->Apply(sizes);
+
+BENCHMARK_MAIN();
@@ -1,8 +1,35 @@
+#include <cstdlib>
+#include <new>
 #include <random>
 #include <functional>
+#include <iomanip>
+#include <sstream>
+#include <vector>
 #include <gtest/gtest.h>
 
 #include "BigInteger.hh"
+#include "Montgomery.hh"
+
+// counts heap allocations, for the tests of the in-place operators
+static size_t allocation_count = 0;
+
+void* operator new(size_t size)
+{
+    ++allocation_count;
+    if (void* p = std::malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
 
 class BigIntegerTest : public ::testing::Test
 {
@@ -90,6 +117,7 @@ TEST_F(BigIntegerTest, CompareTo) {
     EXPECT_EQ(zero.compareTo(zero), 0);
     EXPECT_EQ(one_trillion_neg.compareTo(one_trillion), -1);
     EXPECT_EQ(one_trillion.compareTo(one_trillion_neg), 1);
+    EXPECT_EQ(one_trillion_neg.compareTo(one_neg), -1);
 }
 
 TEST_F(BigIntegerTest, UnsignedCompareTo) {
@@ -127,6 +155,331 @@ TEST_F(BigIntegerTest, MulRandom) {
     }
 }
 
+TEST_F(BigIntegerTest, ToStringRoundTrip) {
+    const std::string str = "-123456789012345678901234567890000000001";
+    EXPECT_EQ(BigInteger(str).toString(), str);
+    EXPECT_EQ(BigInteger("000042").toString(), "42");
+    EXPECT_EQ(BigInteger("-0").toString(), "0");
+    EXPECT_EQ(BigInteger("4294967296").toString(), "4294967296");
+}
+
+TEST_F(BigIntegerTest, LongLongOperands) {
+    EXPECT_EQ(one_trillion + 1000000000000LL, two_trillion);
+    EXPECT_EQ(one_trillion * -2LL, -two_trillion);
+    EXPECT_EQ((zero - 9223372036854775807LL - 1).toString(),
+              "-9223372036854775808");
+}
+
+TEST_F(BigIntegerTest, MulMultiLimb) {
+    BigInteger a("123456789012345678901234567890");
+    BigInteger b("-987654321098765432109876543210");
+    EXPECT_EQ((a * b).toString(),
+              "-121932631137021795226185032733622923332237463801111263526900");
+}
+
+TEST_F(BigIntegerTest, AddCarryAcrossLimbs) {
+    BigInteger a("18446744073709551615");  // 2^64 - 1
+    EXPECT_EQ((a + one).toString(), "18446744073709551616");
+    EXPECT_EQ((a + one - one), a);
+}
+
+// builds a `digits`-digit decimal number from the random generator
+static BigInteger randomBigInteger(std::default_random_engine& generator,
+                                   int digits)
+{
+    std::uniform_int_distribution<int> digit(0, 9);
+    std::string str(digits, '0');
+    str[0] = '1' + digit(generator) % 9;
+    for (int i = 1; i < digits; ++i)
+        str[i] = '0' + digit(generator);
+    return BigInteger(str);
+}
+
+TEST_F(BigIntegerTest, MulTiersAgree) {
+    const limbs::MulThresholds saved = limbs::mul_thresholds;
+    BigInteger a = randomBigInteger(generator, 3000);
+    BigInteger b = -randomBigInteger(generator, 2500);
+    BigInteger c = randomBigInteger(generator, 700);
+
+    limbs::mul_thresholds.karatsuba = limbs::mul_thresholds.toom3 =
+        limbs::mul_thresholds.ntt = 1 << 30;
+    BigInteger ab = a * b, ac = a * c, aa = a * a;
+
+    limbs::MulThresholds tiers[] = { { 8, 1 << 30, 1 << 30 },
+                                     { 8, 16, 1 << 30 },
+                                     { 8, 16, 64 } };
+    for (const auto& tier : tiers) {
+        limbs::mul_thresholds = tier;
+        EXPECT_EQ(a * b, ab);
+        EXPECT_EQ(c * a, ac);
+        EXPECT_EQ(a * a, aa);
+        EXPECT_EQ((a + 1) * (a - 1), aa - 1);
+    }
+    limbs::mul_thresholds = saved;
+}
+
+TEST_F(BigIntegerTest, Div1) {
+    EXPECT_EQ(two_trillion / one_trillion, 2);
+    EXPECT_EQ(one_trillion / two_trillion, zero);
+    EXPECT_EQ(one_trillion_neg / 7, BigInteger("-142857142857"));
+    EXPECT_EQ(one_trillion % 7, 1);
+    EXPECT_EQ(one_trillion_neg % -7, -1);
+}
+
+TEST_F(BigIntegerTest, DivByZero) {
+    EXPECT_THROW(one / zero, std::runtime_error);
+    EXPECT_THROW(one % 0, std::runtime_error);
+}
+
+TEST_F(BigIntegerTest, DivMod) {
+    BigInteger a("-123456789012345678901234567890123456789");
+    BigInteger b("98765432109876543210");
+    BigInteger q, r;
+    a.divmod(b, q, r);
+    EXPECT_EQ(q.toString(), "-1249999988609375000");
+    EXPECT_EQ(r.toString(), "-15297067891529706789");
+    EXPECT_EQ(q * b + r, a);
+    EXPECT_EQ(a / 9000000000000000000LL, BigInteger("-13717421001371742100"));
+}
+
+TEST_F(BigIntegerTest, DivRandomNewton) {
+    const size_t saved = limbs::div_newton_threshold;
+    BigInteger a = randomBigInteger(generator, 4000);
+    BigInteger b = randomBigInteger(generator, 1500);
+    BigInteger q, r;
+    limbs::div_newton_threshold = 1 << 30;
+    a.divmod(b, q, r);
+    limbs::div_newton_threshold = 8;
+    EXPECT_EQ(a / b, q);
+    EXPECT_EQ(a % b, r);
+    EXPECT_EQ(q * b + r, a);
+    EXPECT_LT(r, b);
+    limbs::div_newton_threshold = saved;
+}
+
+TEST_F(BigIntegerTest, CompoundAssign) {
+    BigInteger a = one_trillion;
+    a += one_trillion;
+    EXPECT_EQ(a, two_trillion);
+    a -= two_trillion;
+    EXPECT_EQ(a, zero);
+    a -= one_trillion;
+    EXPECT_EQ(a, one_trillion_neg);
+    a *= -2;
+    EXPECT_EQ(a, two_trillion);
+    a /= 2000000;
+    EXPECT_EQ(a, 1000000);
+    a %= 999;
+    EXPECT_EQ(a, 1);
+    a += a;
+    EXPECT_EQ(a, 2);
+    a -= a;
+    EXPECT_EQ(a, zero);
+}
+
+TEST_F(BigIntegerTest, MoveLeavesZero) {
+    BigInteger a = one_trillion;
+    BigInteger b = std::move(a);
+    EXPECT_EQ(b, one_trillion);
+    EXPECT_EQ(a, zero);
+    a = std::move(b);
+    EXPECT_EQ(a, one_trillion);
+    EXPECT_EQ(b, zero);
+}
+
+TEST_F(BigIntegerTest, AccumulateWithoutAllocation) {
+    BigInteger x = randomBigInteger(generator, 200);
+    BigInteger y = -randomBigInteger(generator, 190);
+    BigInteger sum;
+    for (int i = 0; i < 4; ++i)
+        sum += x;
+    size_t before = allocation_count;
+    for (int i = 0; i < 1000; ++i) {
+        sum += x;
+        sum += y;
+        sum -= 123456789LL;
+        sum *= 1;
+    }
+    EXPECT_FALSE(sum == 42);
+    EXPECT_EQ(allocation_count, before);
+}
+
+TEST_F(BigIntegerTest, SmallValueBoundaries) {
+    BigInteger max64("18446744073709551615");            // 2^64 - 1
+    BigInteger max128("340282366920938463463374607431768211455");
+    // (2^64 - 1)^2 = (2^128 - 1) - 2 (2^64 - 1)
+    EXPECT_EQ(max64 * max64, max128 - max64 * 2);
+    EXPECT_EQ((max128 + 1).toString(),
+              "340282366920938463463374607431768211456");
+    EXPECT_EQ((-max128 - 1).toString(),
+              "-340282366920938463463374607431768211456");
+    EXPECT_EQ(max128.compareTo(max64), 1);
+    EXPECT_EQ((-max128).compareTo(-max64), -1);
+    EXPECT_EQ((-max64).compareTo(-max64), 0);
+    BigInteger small = 12345;
+    BigInteger moved = std::move(small);
+    EXPECT_EQ(moved, 12345);
+    EXPECT_EQ(small, zero);
+}
+
+TEST_F(BigIntegerTest, RadixRoundTrip) {
+    const size_t saved = limbs::radix_dc_threshold;
+    BigInteger a = -randomBigInteger(generator, 5000);
+    std::string decimal = a.toString();
+    limbs::radix_dc_threshold = 2;
+    EXPECT_EQ(a.toString(), decimal);
+    EXPECT_EQ(BigInteger(decimal), a);
+    EXPECT_EQ(BigInteger("1" + std::string(3000, '0')).toString(),
+              "1" + std::string(3000, '0'));
+    limbs::radix_dc_threshold = saved;
+
+    for (int base : { 2, 8, 16 }) {
+        BigInteger b;
+        b.assign(a.toString(base), base);
+        EXPECT_EQ(b, a);
+    }
+    EXPECT_EQ(BigInteger(255).toString(16), "ff");
+    EXPECT_EQ(BigInteger(-5).toString(2), "-101");
+    EXPECT_EQ(zero.toString(8), "0");
+}
+
+TEST_F(BigIntegerTest, AssignBase) {
+    BigInteger a;
+    a.assign("-0x1F", 0);
+    EXPECT_EQ(a, -31);
+    a.assign("0b1010", 0);
+    EXPECT_EQ(a, 10);
+    a.assign("ffffffffffffffffffffffff", 16);
+    EXPECT_EQ(a.toString(), "79228162514264337593543950335");
+    a.assign("0B11", 2);
+    EXPECT_EQ(a, 3);
+    a.assign("0b12", 16);
+    EXPECT_EQ(a, 0xb12);
+    EXPECT_THROW(a.assign("12", 2), std::runtime_error);
+    EXPECT_THROW(a.assign("1g", 16), std::runtime_error);
+}
+
+TEST_F(BigIntegerTest, StreamBases) {
+    std::ostringstream os;
+    os << std::hex << BigInteger(-255) << ' ' << std::showbase << std::uppercase
+       << BigInteger(255) << ' ' << std::oct << BigInteger(8) << ' '
+       << BigInteger::binary << BigInteger(5) << ' ' << std::dec
+       << std::noshowbase << std::setw(6) << BigInteger(-42);
+    EXPECT_EQ(os.str(), "-ff 0XFF 010 0b101    -42");
+
+    std::istringstream is("ff 0x10 0b11 101");
+    BigInteger a, b, c, d;
+    is >> std::hex >> a;
+    is.unsetf(std::ios_base::basefield);
+    is >> b >> c >> BigInteger::binary >> d;
+    EXPECT_EQ(a, 255);
+    EXPECT_EQ(b, 16);
+    EXPECT_EQ(c, 3);
+    EXPECT_EQ(d, 5);
+}
+
+TEST_F(BigIntegerTest, PowMod) {
+    EXPECT_EQ(BigInteger(4).powMod(13, 497), 445);
+    EXPECT_EQ(BigInteger(-2).powMod(3, 5), 2);
+    EXPECT_EQ(BigInteger(7).powMod(0, 1), zero);
+    EXPECT_EQ(one_trillion.powMod(0, 10), 1);
+    EXPECT_THROW(one.powMod(-1, 7), std::runtime_error);
+    EXPECT_THROW(one.powMod(1, 0), std::runtime_error);
+
+    // Fermat's little theorem for the Mersenne prime 2^127 - 1
+    BigInteger p("170141183460469231731687303715884105727");
+    MontgomeryContext context(p);
+    EXPECT_EQ(context.powMod(one_trillion, p - 1), 1);
+    EXPECT_EQ(context.powMod(-two_trillion, p), p - two_trillion);
+    EXPECT_EQ(context.mulMod(p + 2, p - 3), p - 6);
+}
+
+TEST_F(BigIntegerTest, PowModAgreesWithMultiplication) {
+    BigInteger base = randomBigInteger(generator, 300);
+    for (const BigInteger& mod : { randomBigInteger(generator, 200) * 2,
+                                   randomBigInteger(generator, 200) * 2 + 1,
+                                   BigInteger("18446744073709551616") }) {
+        BigInteger expected = 1;
+        for (int exp = 0; exp < 40; ++exp) {
+            EXPECT_EQ(base.powMod(exp, mod), expected);
+            expected = expected * base % mod;
+        }
+    }
+}
+
+TEST_F(BigIntegerTest, SimdLevelsAgree) {
+    const limbs::SimdLevel saved = limbs::simd_level();
+    BigInteger a = randomBigInteger(generator, 2000);
+    BigInteger b = randomBigInteger(generator, 1990);
+    BigInteger all_ones;
+    all_ones.assign(std::string(1001, 'f'), 16);
+    BigInteger power;
+    power.assign("1" + std::string(1001, '0'), 16);
+
+    limbs::set_simd_level(limbs::SimdLevel::scalar);
+    BigInteger sum = a + b, difference = a - b;
+    for (auto level : { limbs::SimdLevel::sse42, limbs::SimdLevel::avx2,
+                        limbs::SimdLevel::avx512 }) {
+        if (!limbs::set_simd_level(level))
+            continue;
+        EXPECT_EQ(a + b, sum);
+        EXPECT_EQ(a - b, difference);
+        EXPECT_EQ(b - a, -difference);
+        EXPECT_EQ(all_ones + 1, power);
+        EXPECT_EQ(power - 1, all_ones);
+        EXPECT_EQ(power.compareTo(power + 1), -1);
+        EXPECT_EQ((a + 1).compareTo(a), 1);
+    }
+    limbs::set_simd_level(saved);
+}
+
+TEST_F(BigIntegerTest, ParallelMulAgrees) {
+    const limbs::MulThresholds saved = limbs::mul_thresholds;
+    const size_t saved_threads = limbs::threads();
+    const size_t saved_grain = limbs::parallel_grain;
+    BigInteger a = randomBigInteger(generator, 6000);
+    BigInteger b = -randomBigInteger(generator, 2500);
+
+    limbs::set_threads(1);
+    BigInteger ab = a * b, aa = a * a;
+    limbs::set_threads(4);
+    limbs::parallel_grain = 8;
+    limbs::MulThresholds tiers[] = { { 8, 1 << 30, 1 << 30 },
+                                     { 8, 16, 1 << 30 },
+                                     { 8, 16, 64 } };
+    for (const auto& tier : tiers) {
+        limbs::mul_thresholds = tier;
+        EXPECT_EQ(a * b, ab);
+        EXPECT_EQ(a * a, aa);
+    }
+    limbs::mul_thresholds = saved;
+    limbs::parallel_grain = saved_grain;
+    limbs::set_threads(saved_threads);
+}
+
+TEST_F(BigIntegerTest, Product) {
+    const size_t saved_threads = limbs::threads();
+    const size_t saved_grain = limbs::parallel_grain;
+    std::vector<BigInteger> none;
+    EXPECT_EQ(BigInteger::product(none.begin(), none.end()), 1);
+
+    std::vector<int> factors;
+    BigInteger factorial = 1;
+    for (int i = 1; i <= 500; ++i) {
+        factors.push_back(i);
+        factorial *= i;
+    }
+    limbs::set_threads(3);
+    limbs::parallel_grain = 2;
+    EXPECT_EQ(BigInteger::product(factors.begin(), factors.end()), factorial);
+    factors.push_back(-1);
+    EXPECT_EQ(BigInteger::product(factors.begin(), factors.end()), -factorial);
+    factors.push_back(0);
+    EXPECT_EQ(BigInteger::product(factors.begin(), factors.end()), zero);
+    limbs::parallel_grain = saved_grain;
+    limbs::set_threads(saved_threads);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);